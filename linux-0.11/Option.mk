@@ -37,3 +37,20 @@ CFLAGS  = $(DEBUG) -m32 \
 	-fomit-frame-pointer \
 	-fstrength-reduce \
 	-nostdinc 
+
+# 如果要统计每个系统调用的次数和耗时分布（读 /dev/sysstat），就去掉下面一行的注释符
+# 也可以用 make SYSCALL_STATS=1 临时打开。C 代码和 kernel/system_call.s 都要知道这个选项
+#SYSCALL_STATS = 1
+
+ifdef SYSCALL_STATS
+AS	+= --defsym SYSCALL_STATS=1
+CFLAGS	+= -DSYSCALL_STATS
+endif
+
+# 如果要统计关中断的时间、找出关中断最长的代码（读 /dev/irqlat），就去掉下面一行的注释符
+# cli()/sti() 是 <asm/system.h> 中的宏，改变这个选项后要先 make clean 再重新编译整个内核
+#IRQ_LATENCY = 1
+
+ifdef IRQ_LATENCY
+CFLAGS	+= -DIRQ_LATENCY
+endif
@@ -38,6 +38,7 @@ INITSEG  = 0x9000			! 将 bootsect 移到这里，避开 0x7c00 这个位置；
 SETUPSEG = 0x9020			! setup 程序从这里开始；
 SYSSEG   = 0x1000			! system 模块加载到 0x10000 (64 kB) 处；
 ENDSEG   = SYSSEG + SYSSIZE	! 停止加载的段地址；
+BOOTLOG  = 0x0A00			! 启动时间记录在 INITSEG:BOOTLOG 处，紧接在 setup 之后，见 include/linux/bootlog.h
 
 ! ROOT_DEV:	0x000 - 根文件系统设备使用与引导时同样的软驱设备
 !		0x301 - 根文件系统设备在第一个硬盘的第一个分区上，等等；
@@ -107,6 +108,14 @@ go:
 	! 任意远远大于 0x200 的数，确保程序执行过程中，栈不会溢出
 	mov	sp,#0xFF00
 
+	! 记录引导开始的时间：int 0x1a 功能 0 取 BIOS 时钟滴答数（每秒约 18.2 次）到 cx:dx
+	xor	ah,ah
+	int	0x1a
+	seg cs
+	mov	[BOOTLOG],dx
+	seg cs
+	mov	[BOOTLOG+2],cx
+
 	! 由于代码段移动过了，所以要重新设置堆栈段的位置。
 	! sp 只要指向远大于512 偏移 (即地址0x90200) 处
 	! 都可以。因为从0x90200 地址开始处还要放置setup 程序，
@@ -228,6 +237,14 @@ ok_load_setup:
 	! 关闭驱动器马达
 	call	kill_motor
 
+	! 记录 system 加载完毕的时间
+	xor	ah,ah
+	int	0x1a
+	seg cs
+	mov	[BOOTLOG+4],dx
+	seg cs
+	mov	[BOOTLOG+6],cx
+
 	! 然后，我们检查要使用哪个根文件系统设备 (简称根设备) 
 	! 如果已经指定了设备(!=0)，就直接使用给定的设备
 	! 否则就需要根据BIOS 报告的每磁道扇区数来
@@ -20,6 +20,10 @@ SYSSEG   = 0x1000
 ! 本程序所在的段地址
 SETUPSEG = 0x9020
 
+! 启动时间记录在 INITSEG:BOOTLOG 处，前两项由 bootsect.s 写入，见 include/linux/bootlog.h
+BOOTLOG  = 0x0A00
+BOOTMAGIC = 0x4c42
+
 .globl begtext, begdata, begbss, endtext, enddata, endbss
 .text
 begtext:
@@ -40,6 +44,12 @@ start:
 	mov	ax,#INITSEG
 	mov	ds,ax
 
+	! 记录 setup 开始运行的时间（BIOS 时钟滴答数）
+	xor	ah,ah
+	int	0x1a
+	mov	[BOOTLOG+8],dx
+	mov	[BOOTLOG+10],cx
+
 	! 获取光标位置, 
 	! 返回值 (DH, DL) 对应 (行, 列)
 	mov	ah,#0x03
@@ -176,6 +186,16 @@ no_disk1:
 
 is_disk1:
 
+	! 记录进入保护模式之前的时间，并写入标志，表示实模式的时间记录有效
+	mov	ax,#INITSEG
+	mov	ds,ax
+	xor	ah,ah
+	int	0x1a
+	mov	[BOOTLOG+12],dx
+	mov	[BOOTLOG+14],cx
+	mov	ax,#BOOTMAGIC
+	mov	[BOOTLOG+16],ax
+
 ! 现在我们要开始进入保护模式了...
 
 	! 关中断
@@ -0,0 +1,351 @@
+/*
+ *  linux/fs/aio.c
+ */
+
+// 常规文件和块设备的异步读写 aio_submit() / aio_getevents()
+// 提交时只为各数据块取得缓冲区并以 READA/WRITEA 方式发出请求，并不等待 I/O 完成，
+// 因此一个进程可以一次让许多块同时在请求队列中等待磁盘处理
+// 已完成的操作在 aio_getevents() 中（进程自己的上下文里）把数据复制到用户缓冲区，
+// 并放入进程的完成环中，再从完成环中取出交给用户程序
+// 预读/写请求在请求队列已满或缓冲块正被使用时会被放弃，此时在检查完成情况时改用 READ/WRITE 重新提交
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/aio.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <asm/segment.h>
+#include <asm/system.h>
+
+// 一个正在进行的异步读写操作
+struct aio_op
+{
+	struct m_inode *inode;	 // 文件 i 节点，为空表示该项空闲
+	char *buf;				 // 用户缓冲区
+	unsigned long data;		 // 用户数据
+	int rw;					 // READ 或 WRITE
+	int offset;				 // 第一块中的起始偏移
+	int res;				 // 操作结果：读写的字节数或出错码
+	int nr;					 // 使用的缓冲块数
+	unsigned long retry;	 // 已用 READ/WRITE 重新提交过的缓冲块位图
+	struct buffer_head *bh[AIO_MAX_BLOCKS]; // 各块的缓冲区，常规文件中的空洞为空
+};
+
+// 进程的异步 I/O 上下文，第一次提交时分配一页内存存放
+// 尚未完成的操作数加上完成环中尚未取走的事件数不超过 AIO_MAX，因此完成环不会溢出
+struct aio_context
+{
+	struct aio_op op[AIO_MAX];			 // 操作表
+	struct aio_event ring[AIO_MAX];		 // 完成环
+	unsigned long head, tail;			 // 完成环的头（放入）、尾（取出）计数
+	int nr_ops;							 // 尚未完成的操作数
+};
+
+// 开始一个异步读写操作，cb 是已复制到内核中的控制块
+// 返回：0 表示已提交，否则为出错码
+static int aio_start(struct aio_op *op, struct aiocb *cb)
+{
+	struct file *file;
+	struct m_inode *inode;
+	struct buffer_head *bh;
+	off_t pos = cb->aio_offset;
+	int count = cb->aio_nbytes;
+	char *buf = cb->aio_buf, *p;
+	int isreg, dev, block, chars, i;
+
+	if (cb->aio_fildes < 0 || cb->aio_fildes >= NR_OPEN || !(file = current->filp[cb->aio_fildes]))
+		return -EBADF;
+	inode = file->f_inode;
+	if (!(isreg = S_ISREG(inode->i_mode)) && !S_ISBLK(inode->i_mode))
+		return -EINVAL;
+
+	// proc 中的文件没有数据块，内容由 proc_read() 生成
+	if (inode->i_dev == PROC_DEV)
+		return -EINVAL;
+
+	// 读写方式要与打开文件时的方式相符
+	if ((cb->aio_lio_opcode == AIO_READ && (file->f_flags & O_ACCMODE) == O_WRONLY) ||
+		(cb->aio_lio_opcode == AIO_WRITE && (file->f_flags & O_ACCMODE) == O_RDONLY))
+		return -EBADF;
+	if (count < 0 || count > AIO_MAX_BYTES || pos < 0)
+		return -EINVAL;
+	dev = isreg ? inode->i_dev : inode->i_zone[0];
+	op->buf = buf;
+	op->data = cb->aio_data;
+	op->offset = pos % BLOCK_SIZE;
+	op->retry = 0;
+	op->nr = 0;
+
+	switch (cb->aio_lio_opcode)
+	{
+	case AIO_READ:
+		// 常规文件的读操作不能超过文件末尾
+		if (isreg)
+		{
+			if (pos >= inode->i_size)
+				count = 0;
+			else if (count > inode->i_size - pos)
+				count = inode->i_size - pos;
+			inode->i_atime = CURRENT_TIME;
+		}
+		verify_area(buf, count);
+
+		// 为各块取得缓冲区，数据还未读入的发出预读请求
+		op->rw = READ;
+		op->nr = (op->offset + count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		for (i = 0; i < op->nr; i++)
+		{
+			block = pos / BLOCK_SIZE + i;
+			if (isreg && !(block = bmap(inode, block)))
+			{
+				op->bh[i] = NULL;
+				continue;
+			}
+			op->bh[i] = bh = getblk(dev, block);
+			if (!bh->b_uptodate)
+				ll_rw_block(READA, bh);
+		}
+		op->res = count;
+		break;
+
+	case AIO_WRITE:
+		// 用户数据在提交时就复制到缓冲块中，此后用户缓冲区可以立即重用
+		// 常规文件写时需要时分配新块，分配不到则只写前面的块
+		op->rw = WRITE;
+		op->res = 0;
+		for (i = 0; count > 0; i++)
+		{
+			block = pos / BLOCK_SIZE;
+			if (isreg && !(block = create_block(inode, block)))
+				break;
+			chars = BLOCK_SIZE - pos % BLOCK_SIZE;
+			if (chars > count)
+				chars = count;
+			// 整块覆盖时不必先读入块中原有的数据
+			if (chars == BLOCK_SIZE)
+				bh = getblk(dev, block);
+			else
+				bh = bread(dev, block);
+			if (!bh)
+				break;
+			p = bh->b_data + pos % BLOCK_SIZE;
+			pos += chars;
+			op->res += chars;
+			count -= chars;
+			while (chars-- > 0)
+				*(p++) = get_fs_byte(buf++);
+			bh->b_uptodate = 1;
+			bh->b_dirt = 1;
+			op->bh[i] = bh;
+			op->nr = i + 1;
+			ll_rw_block(WRITEA, bh);
+		}
+		if (!op->res && count)
+			return isreg ? -ENOSPC : -EIO;
+		if (isreg)
+		{
+			if (pos > inode->i_size)
+			{
+				inode->i_size = pos;
+				inode->i_dirt = 1;
+			}
+			inode->i_mtime = inode->i_ctime = CURRENT_TIME;
+		}
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	op->inode = inode;
+	inode->i_count++;
+	return 0;
+}
+
+// 检查操作是否已经完成
+// 被放弃的预读/写（缓冲块解锁后数据仍未读入或仍是脏的）在这里用 READ/WRITE 重新提交，
+// 重新提交后仍然失败的读操作以及失败的写操作（缓冲块不再有效）结果为 -EIO
+// 返回：1 表示已完成，0 表示还有块在进行 I/O
+static int aio_done(struct aio_op *op)
+{
+	struct buffer_head *bh;
+	int i;
+
+	for (i = 0; i < op->nr; i++)
+	{
+		if (!(bh = op->bh[i]))
+			continue;
+		if (bh->b_lock)
+			return 0;
+		if (op->rw == READ)
+		{
+			if (bh->b_uptodate)
+				continue;
+			if (op->retry & (1 << i))
+			{
+				op->res = -EIO;
+				continue;
+			}
+		}
+		else if (!bh->b_dirt)
+		{
+			if (!bh->b_uptodate)
+				op->res = -EIO;
+			continue;
+		}
+		op->retry |= 1 << i;
+		ll_rw_block(op->rw, bh);
+		return 0;
+	}
+	return 1;
+}
+
+// 结束一个已完成的操作：读操作把数据复制到用户缓冲区（空洞读出为 0），
+// 然后释放缓冲块和 i 节点，把结果放入完成环
+static void aio_complete(struct aio_context *ctx, struct aio_op *op)
+{
+	struct aio_event *ev;
+	char *p, *buf = op->buf;
+	int left, chars, i;
+
+	if (op->rw == READ && op->res > 0)
+	{
+		verify_area(buf, op->res);
+		left = op->res;
+		for (i = 0; i < op->nr && left > 0; i++)
+		{
+			chars = BLOCK_SIZE - (i ? 0 : op->offset);
+			if (chars > left)
+				chars = left;
+			left -= chars;
+			if (op->bh[i])
+			{
+				p = op->bh[i]->b_data + (i ? 0 : op->offset);
+				while (chars-- > 0)
+					put_fs_byte(*(p++), buf++);
+			}
+			else
+				while (chars-- > 0)
+					put_fs_byte(0, buf++);
+		}
+	}
+
+	for (i = 0; i < op->nr; i++)
+		brelse(op->bh[i]);
+	iput(op->inode);
+	op->inode = NULL;
+	ctx->nr_ops--;
+
+	ev = ctx->ring + (ctx->head++ & (AIO_MAX - 1));
+	ev->data = op->data;
+	ev->res = op->res;
+}
+
+// 系统调用 aio_submit()，提交控制块数组 list 中的 nr 个异步读写操作
+// 返回：成功提交的操作数；若第一个就无法提交则返回出错码
+// 操作数已达 AIO_MAX（包括尚未取走的完成事件）时返回 -EAGAIN
+int sys_aio_submit(struct aiocb *list, int nr)
+{
+	struct aio_context *ctx;
+	struct aio_op *op;
+	struct aiocb cb;
+	int i, j, error = 0;
+
+	if (nr < 0)
+		return -EINVAL;
+	if (!(ctx = current->aio))
+	{
+		if (!(ctx = (struct aio_context *)get_free_page()))
+			return -ENOMEM;
+		current->aio = ctx;
+	}
+	for (i = 0; i < nr; i++)
+	{
+		if (ctx->nr_ops + ctx->head - ctx->tail >= AIO_MAX)
+		{
+			error = -EAGAIN;
+			break;
+		}
+		for (j = 0; j < sizeof(cb) / 4; j++)
+			((unsigned long *)&cb)[j] = get_fs_long(((unsigned long *)(list + i)) + j);
+		for (op = ctx->op; op->inode; op++)
+			;
+		if ((error = aio_start(op, &cb)))
+			break;
+		ctx->nr_ops++;
+	}
+	return i ? i : error;
+}
+
+// 系统调用 aio_getevents()，取最多 nr 个完成事件到用户数组 events 中
+// 若完成事件少于 min_nr 个，则等待直到满足或者所有操作都已完成；min_nr 为 0 时只是查询
+// 返回：取得的事件数
+int sys_aio_getevents(struct aio_event *events, int nr, int min_nr)
+{
+	struct aio_context *ctx = current->aio;
+	struct aio_op *op;
+	struct buffer_head *bh;
+	int got = 0, i;
+
+	if (nr < 0 || min_nr < 0 || min_nr > nr)
+		return -EINVAL;
+	if (!ctx)
+		return 0;
+	verify_area(events, nr * sizeof(struct aio_event));
+	for (;;)
+	{
+		// 收集已完成的操作，并从完成环中取出事件
+		for (op = ctx->op; op < ctx->op + AIO_MAX; op++)
+			if (op->inode && aio_done(op))
+				aio_complete(ctx, op);
+		for (; got < nr && ctx->tail != ctx->head; got++, ctx->tail++)
+		{
+			put_fs_long(ctx->ring[ctx->tail & (AIO_MAX - 1)].data, (unsigned long *)(events + got));
+			put_fs_long(ctx->ring[ctx->tail & (AIO_MAX - 1)].res, (unsigned long *)&events[got].res);
+		}
+		if (got >= min_nr || !ctx->nr_ops)
+			break;
+
+		// 睡眠等待某个正在进行 I/O 的缓冲块解锁
+		bh = NULL;
+		for (op = ctx->op; op < ctx->op + AIO_MAX && !bh; op++)
+			for (i = 0; op->inode && i < op->nr; i++)
+				if (op->bh[i] && op->bh[i]->b_lock)
+				{
+					bh = op->bh[i];
+					break;
+				}
+		if (bh)
+		{
+			cli();
+			while (bh->b_lock)
+				sleep_on(&bh->b_wait);
+			sti();
+		}
+	}
+	return got;
+}
+
+// 撤销当前进程的异步 I/O 上下文，在 exit() 和 execve() 时调用
+// 未完成的操作直接放弃：读入的数据不再复制，写操作的数据仍留在高速缓冲中，以后会被写回设备
+void exit_aio(void)
+{
+	struct aio_context *ctx = current->aio;
+	struct aio_op *op;
+	int i;
+
+	if (!ctx)
+		return;
+	for (op = ctx->op; op < ctx->op + AIO_MAX; op++)
+		if (op->inode)
+		{
+			for (i = 0; i < op->nr; i++)
+				brelse(op->bh[i]);
+			iput(op->inode);
+		}
+	current->aio = NULL;
+	free_page((unsigned long)ctx);
+}
@@ -18,6 +18,7 @@
 #include <linux/config.h>
 #include <linux/sched.h>
 #include <linux/kernel.h>
+#include <linux/trace.h>
 #include <asm/system.h>
 #include <asm/io.h>
 
@@ -32,6 +33,9 @@ static struct buffer_head *free_list;
 static struct task_struct *buffer_wait = NULL;
 int NR_BUFFERS = 0;
 
+// 高速缓冲和块设备的累计统计，块设备部分由 kernel/blk_drv/ll_rw_blk.c 更新
+struct blk_stat blk_stat;
+
 // 等待指定缓冲区解锁
 static inline void wait_on_buffer(struct buffer_head *bh)
 {
@@ -52,6 +56,8 @@ int sys_sync(void)
 	int i;
 	struct buffer_head *bh;
 
+	blk_stat.sync++;
+
 	// 将 i 节点写入高速缓冲
 	sync_inodes();
 
@@ -74,6 +80,7 @@ int sync_dev(int dev)
 	int i;
 	struct buffer_head *bh;
 
+	blk_stat.sync_dev++;
 	bh = start_buffer;
 	for (i = 0; i < NR_BUFFERS; i++, bh++)
 	{
@@ -121,6 +128,28 @@ static void inline invalidate_buffers(int dev)
 	}
 }
 
+// 直接 I/O（O_DIRECT）之前保持高速缓冲与设备数据的一致
+// 读之前：若该块在高速缓冲中已被修改，先把它写盘，这样从设备直接读到的就是最新数据
+// 写之前：丢弃高速缓冲中该块的数据，以免以后读到旧数据，或者旧数据写盘时覆盖新数据
+void sync_direct_block(int rw, int dev, int block)
+{
+	struct buffer_head *bh;
+
+	if (!(bh = get_hash_table(dev, block)))
+		return;
+	if (rw == READ)
+	{
+		if (bh->b_dirt)
+		{
+			ll_rw_block(WRITE, bh);
+			wait_on_buffer(bh);
+		}
+	}
+	else
+		bh->b_uptodate = bh->b_dirt = 0;
+	brelse(bh);
+}
+
 // 该子程序检查一个软盘是否已经被更换
 // 如果已经更换就使高速缓冲中与该软驱对应的所有缓冲区无效
 // 该子程序相对来说较慢，所以我们要尽量少使用它
@@ -199,7 +228,9 @@ static inline void insert_into_queues(struct buffer_head *bh)
 		return;
 	bh->b_next = hash(bh->b_dev, bh->b_blocknr);
 	hash(bh->b_dev, bh->b_blocknr) = bh;
-	bh->b_next->b_prev = bh;
+	// 原来的代码没有判断 hash 队列是否为空，会通过空指针改写地址 0x14 处（页目录表）的内容
+	if (bh->b_next)
+		bh->b_next->b_prev = bh;
 }
 
 // 在高速缓冲中寻找给定设备和指定块的缓冲区块
@@ -260,7 +291,16 @@ struct buffer_head *getblk(int dev, int block)
 repeat:
 	// 搜索 hash 表，如果指定块已经在高速缓冲中，则返回对应缓冲区头指针，退出
 	if ((bh = get_hash_table(dev, block)))
+	{
+		trace(TRACE_GETBLK_HIT, dev, block);
+		blk_stat.getblk_hit++;
+		if (bh->b_reada)
+		{
+			blk_stat.reada_useful++;
+			bh->b_reada = 0;
+		}
 		return bh;
+	}
 
 	// 扫描空闲数据块链表，寻找空闲缓冲区
 	// 首先让 tmp 指向空闲链表的第一个空闲缓冲区头
@@ -288,6 +328,7 @@ repeat:
 	// 则睡眠，等待有空闲的缓冲区可用
 	if (!bh)
 	{
+		blk_stat.buffer_wait++;
 		sleep_on(&buffer_wait);
 		goto repeat;
 	}
@@ -323,6 +364,7 @@ repeat:
 	bh->b_count = 1;
 	bh->b_dirt = 0;
 	bh->b_uptodate = 0;
+	bh->b_reada = 0;
 
 	// 从 hash 队列和空闲块链表中移出该缓冲区头，让该缓冲区用于指定设备和其上的指定块
 	remove_from_queues(bh);
@@ -331,6 +373,8 @@ repeat:
 
 	// 然后根据此新的设备号和块号，重新插入空闲链表和 hash 队列新位置处，并最终返回缓冲头指针
 	insert_into_queues(bh);
+	trace(TRACE_GETBLK_MISS, dev, block);
+	blk_stat.getblk_miss++;
 	return bh;
 }
 
@@ -364,6 +408,7 @@ struct buffer_head *bread(int dev, int block)
 		return bh;
 
 	// 否则调用 ll_rw_block() 函数，产生读设备块请求，并等待缓冲区解锁
+	blk_stat.bread_wait++;
 	ll_rw_block(READ, bh);
 	wait_on_buffer(bh);
 
@@ -439,18 +484,29 @@ struct buffer_head *breada(int dev, int first, ...)
 	if (!(bh = getblk(dev, first)))
 		panic("bread: getblk returned NULL\n");
 	if (!bh->b_uptodate)
+	{
+		blk_stat.bread_wait++;
 		ll_rw_block(READ, bh);
+	}
 
 	// 然后顺序取可变参数表中其它预读块号，并作与上面同样处理，但不引用
-	// 注意，下面 ll_rw_block 参数有一个bug
-	// 其中的 bh 应该是 tmp，这个 bug 直到在 0.96 版的内核代码中才被纠正过来
+	// 原来这里的 ll_rw_block 参数有一个 bug：用的是 bh 而不是 tmp（0.96 版才纠正），
+	// 预读请求发给了已上锁的第 1 块而被丢弃，实际上从来没有预读过
 	while ((first = va_arg(args, int)) >= 0)
 	{
 		tmp = getblk(dev, first);
 		if (tmp)
 		{
 			if (!tmp->b_uptodate)
-				ll_rw_block(READA, bh);
+			{
+				ll_rw_block(READA, tmp);
+				// 请求项不够时 make_request() 会丢弃预读，这时缓冲区没有上锁，不算作预读
+				if (tmp->b_lock || tmp->b_uptodate)
+				{
+					blk_stat.reada_issued++;
+					tmp->b_reada = 1;
+				}
+			}
 			tmp->b_count--;
 		}
 	}
@@ -466,6 +522,26 @@ struct buffer_head *breada(int dev, int first, ...)
 	return (NULL);
 }
 
+// 取高速缓冲和块设备的统计：复制累计计数，并统计当前各缓冲区的状态和各请求队列的长度
+void get_blk_stat(struct blk_stat *s)
+{
+	struct buffer_head *bh;
+	int i;
+
+	*s = blk_stat;
+	s->nr_buffers = NR_BUFFERS;
+	s->nr_dirty = s->nr_locked = 0;
+	for (bh = start_buffer, i = 0; i < NR_BUFFERS; i++, bh++)
+	{
+		if (bh->b_dirt)
+			s->nr_dirty++;
+		if (bh->b_lock)
+			s->nr_locked++;
+	}
+	for (i = 0; i < NR_BLK_STAT; i++)
+		s->queue_depth[i] = blk_queue_depth(i);
+}
+
 // 缓冲区初始化函数
 // 参数 buffer_end 是指定的缓冲区内存的末端
 // 对于系统有 16MB 内存，则缓冲区末端设置为 4MB
@@ -9,16 +9,14 @@
 
 #include <linux/sched.h>
 #include <linux/kernel.h>
+#include <linux/tty.h>
+#include <linux/trace.h>
+#include <linux/sysstat.h>
+#include <linux/irqlat.h>
 
 #include <asm/segment.h>
 #include <asm/io.h>
 
-// 终端读
-extern int tty_read(unsigned minor, char *buf, int count);
-
-// 终端写
-extern int tty_write(unsigned minor, char *buf, int count);
-
 // 定义字符设备读写函数指针类型
 typedef int (*crw_ptr)(int rw, unsigned minor, char *buf, int count, off_t *pos);
 
@@ -26,8 +24,12 @@ typedef int (*crw_ptr)(int rw, unsigned minor, char *buf, int count, off_t *pos)
 // 参数：rw - 读写命令；minor - 终端子设备号；buf - 缓冲区；cout - 读写字节数；
 // pos - 读写操作当前指针，对于终端操作，该指针无用
 // 返回：实际读写的字节数。
+// 伪终端主端的读写取走从端的输出、作为从端的输入，见 pty.c
 static int rw_ttyx(int rw, unsigned minor, char *buf, int count, off_t *pos)
 {
+	if (IS_PTY_MASTER(minor))
+		return ((rw == READ) ? pty_master_read(minor - PTY_MASTER, buf, count)
+							 : pty_master_write(minor - PTY_MASTER, buf, count));
 	return ((rw == READ) ? tty_read(minor, buf, count) : tty_write(minor, buf, count));
 }
 
@@ -90,6 +92,51 @@ static int rw_port(int rw, char *buf, int count, off_t *pos)
 	return i;
 }
 
+// 读内核中的一块数据：从长度为 size 的 src 的 *pos 处复制最多 count 字节到用户缓冲区 buf，并前移 *pos
+// /dev/profile、/dev/sysstat、/dev/blkstat 和 /dev/irqlat 的读操作都用它
+// 返回：实际读出的字节数，已到末尾返回 0
+static int read_kernel_buf(char *buf, int count, off_t *pos, const void *src, unsigned long size)
+{
+	if (*pos < 0 || *pos >= size)
+		return 0;
+	if (count > size - *pos)
+		count = size - *pos;
+	memcpy_tofs(buf, (const char *)src + *pos, count);
+	*pos += count;
+	return count;
+}
+
+// 内核 PC 采样直方图读写函数
+// 读：从 pos 处开始读出 prof_buffer[] 中的计数（每个计数为一个长字）；写：把所有计数清零
+// 参数：rw - 读写命令；buf - 缓冲区；cout - 读写字节数；pos - 读写指针
+// 返回：实际读写的字节数，内核编译时没有打开 PC 采样则返回 -EIO
+static int rw_profile(int rw, char *buf, int count, off_t *pos)
+{
+	unsigned long i;
+
+	if (!prof_buffer)
+		return -EIO;
+	if (rw == WRITE)
+	{
+		for (i = 0; i < prof_len; i++)
+			prof_buffer[i] = 0;
+		return count;
+	}
+	return read_kernel_buf(buf, count, pos, prof_buffer, prof_len * sizeof(long));
+}
+
+// 高速缓冲和块设备统计的读函数，从 pos 处开始读出 blk_stat 结构，该设备只读
+// 返回：实际读出的字节数，写返回 -EIO
+static int rw_blkstat(int rw, char *buf, int count, off_t *pos)
+{
+	struct blk_stat s;
+
+	if (rw != READ)
+		return -EIO;
+	get_blk_stat(&s);
+	return read_kernel_buf(buf, count, pos, &s, sizeof(s));
+}
+
 // 内存读写操作函数
 static int rw_memory(int rw, unsigned minor, char *buf, int count, off_t *pos)
 {
@@ -106,6 +153,20 @@ static int rw_memory(int rw, unsigned minor, char *buf, int count, off_t *pos)
 		return (rw == READ) ? 0 : count; /* rw_null */
 	case 4:
 		return rw_port(rw, buf, count, pos);
+	case 5:
+		return rw_profile(rw, buf, count, pos);
+	case 6:
+		return (rw == READ) ? trace_read(buf, count) : trace_write(buf, count);
+#ifdef SYSCALL_STATS
+	case 7:
+		return (rw == READ) ? read_kernel_buf(buf, count, pos, sysstat, sizeof(sysstat)) : sysstat_write(buf, count);
+#endif
+	case 8:
+		return rw_blkstat(rw, buf, count, pos);
+#ifdef IRQ_LATENCY
+	case 9:
+		return (rw == READ) ? read_kernel_buf(buf, count, pos, irqlat, sizeof(irqlat)) : irqlat_write(buf, count);
+#endif
 	default:
 		return -EIO;
 	}
@@ -0,0 +1,151 @@
+/*
+ *  linux/fs/direct_io.c
+ */
+
+// 以 O_DIRECT 方式打开的常规文件和块设备的读写
+// 数据不经过高速缓冲，而是由 ll_rw_direct() 在用户页面与设备之间直接传送，
+// 这样大量的顺序读写不会把高速缓冲中有用的元数据块和目录块挤出去
+// 读写位置、用户缓冲区地址和字节数都必须是数据块长度（1024 字节）的整数倍
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <asm/segment.h>
+
+// 写页面验证，在 mm/memory.c 中
+extern void write_verify(unsigned long address);
+
+// 直接读写
+// rw - READ 或 WRITE；file - 文件结构；buf - 用户缓冲区；count - 字节数
+// 返回：读写的字节数，出错则返回出错码
+int direct_rw(int rw, struct file *file, char *buf, int count)
+{
+	struct m_inode *inode = file->f_inode;
+	unsigned long base, phys;
+	off_t pos, limit = 0;
+	int b[4], dev, nr, chars, i, j, err, error = 0, done = 0;
+	int isreg = S_ISREG(inode->i_mode);
+
+	// buf 必须是用户地址，下面按进程的页表换算成物理地址。fs 不是用户数据段时
+	// （内核令 fs = ds 后调用读写函数）buf 是内核地址，调用者应改用经过高速缓冲的读写
+	if (get_fs() != 0x17)
+		return -EINVAL;
+
+	// 取读写位置，以添加方式打开的文件总是写在文件末尾
+	pos = file->f_pos;
+	if (isreg && rw == WRITE && (file->f_flags & O_APPEND))
+		pos = inode->i_size;
+	if ((pos | (unsigned long)buf | count) & (BLOCK_SIZE - 1))
+		return -EINVAL;
+	dev = isreg ? inode->i_dev : inode->i_zone[0];
+
+	// 常规文件的读操作不能超过文件末尾，但最后一块仍要整块读入
+	if (isreg && rw == READ)
+	{
+		if (pos >= inode->i_size)
+			return 0;
+		limit = inode->i_size - pos;
+		if (count > limit)
+			count = (limit + BLOCK_SIZE - 1) & ~(BLOCK_SIZE - 1);
+	}
+
+	base = get_base(current->ldt[2]);
+	while (count > 0)
+	{
+		// 每次最多处理到用户缓冲区所在页面的末尾，页面内的块在物理内存中是连续的
+		chars = PAGE_SIZE - ((unsigned long)buf & (PAGE_SIZE - 1));
+		if (chars > count)
+			chars = count;
+		nr = chars / BLOCK_SIZE;
+
+		// 让页面存在。对于读操作还要取消页面的写保护（写时复制），
+		// 因为内核态写页面时 CPU 并不检查写保护
+		(void)get_fs_byte(buf);
+		if (rw == READ)
+			write_verify(base + (unsigned long)buf);
+		if (!(phys = get_phys_addr(base + (unsigned long)buf)))
+		{
+			error = -EFAULT;
+			break;
+		}
+
+		// 取得各块在设备上的块号。常规文件写时需要时分配新块，分配不到则只写前面的块
+		for (i = 0; i < nr; i++)
+		{
+			if (!isreg)
+				b[i] = pos / BLOCK_SIZE + i;
+			else if (rw == READ)
+				b[i] = bmap(inode, pos / BLOCK_SIZE + i);
+			else if (!(b[i] = create_block(inode, pos / BLOCK_SIZE + i)))
+			{
+				nr = i;
+				error = -ENOSPC;
+				break;
+			}
+			if (b[i] || !isreg)
+				sync_direct_block(rw, dev, b[i]);
+		}
+
+		// 对设备上连续的一段块发出直接 I/O 请求，文件中的空洞直接清零
+		for (i = 0; i < nr; i = j)
+		{
+			if (isreg && !b[i])
+			{
+				for (j = 0; j < BLOCK_SIZE / 4; j++)
+					((long *)(phys + i * BLOCK_SIZE))[j] = 0;
+				j = i + 1;
+				continue;
+			}
+			for (j = i + 1; j < nr && (b[j] || !isreg); j++)
+				;
+			if ((err = ll_rw_direct(rw, dev, b + i, j - i, (char *)phys + i * BLOCK_SIZE)))
+			{
+				nr = 0;
+				error = err;
+				break;
+			}
+		}
+
+		// 读入的数据是由设备直接写进页面的，要置页面的已修改标志（出错时页面也可能已被部分写入）
+		if (rw == READ)
+			set_page_dirty(base + (unsigned long)buf);
+		chars = nr * BLOCK_SIZE;
+		pos += chars;
+		buf += chars;
+		done += chars;
+		count -= chars;
+		if (error)
+			break;
+	}
+
+	if (isreg)
+	{
+		if (rw == READ)
+		{
+			// 超出文件末尾的部分清零，不计入读取的字节数
+			if (done > limit)
+			{
+				for (i = done - limit; i > 0; i--)
+					put_fs_byte(0, buf - i);
+				pos -= done - limit;
+				done = limit;
+			}
+			inode->i_atime = CURRENT_TIME;
+		}
+		else
+		{
+			if (pos > inode->i_size)
+			{
+				inode->i_size = pos;
+				inode->i_dirt = 1;
+			}
+			inode->i_mtime = inode->i_ctime = CURRENT_TIME;
+		}
+	}
+	if (!(isreg && rw == WRITE && (file->f_flags & O_APPEND)))
+		file->f_pos = pos;
+	return done ? done : error;
+}
@@ -32,6 +32,7 @@
 #include <linux/sched.h>
 #include <linux/kernel.h>
 #include <linux/mm.h>
+#include <linux/bootlog.h>
 #include <asm/segment.h>
 
 // 程序退出系统调用
@@ -494,10 +495,11 @@ restart_interp:
 	// 下面对执行头信息进行处理
 	// 对于下列情况，将不执行程序：
 	// 如果执行文件不是需求页可执行文件(ZMAGIC)、或者代码重定位部分长度 a_trsize 不等于 0
-	// 或者数据重定位信息长度不等于 0、或者代码段+数据段+堆段长度超过 50MB、
+	// 或者数据重定位信息长度不等于 0、或者代码段+数据段+堆段长度超过 46MB
+	// （SHM_START，之上是共享内存附加区和文件映射区，sys_brk() 也以此为上限）、
 	// 或者 i 节点表明的该执行文件长度小于代码段+数据段+符号表长度+执行头部分长度的总和
 	if (N_MAGIC(ex) != ZMAGIC || ex.a_trsize || ex.a_drsize ||
-		ex.a_text + ex.a_data + ex.a_bss > 0x3000000 ||
+		ex.a_text + ex.a_data + ex.a_bss > SHM_START ||
 		inode->i_size < ex.a_text + ex.a_data + ex.a_syms + N_TXTOFF(ex))
 	{
 		retval = -ENOEXEC;
@@ -550,6 +552,11 @@ restart_interp:
 	// 释放原来进程 代码段 和 数据段 所对应的 内存页表 指定的 内存块 及 页表 本身
 	// 此时被执行程序没有占用主内存区任何页面
 	// 在执行时会引起内存管理程序执行缺页处理而为其申请内存页面，并把程序读入内存
+	// 原程序的文件映射区、异步 I/O 操作、附加的共享内存段和 profil() 采样也随之撤销
+	exit_mmap();
+	exit_aio();
+	exit_shm();
+	current->prof_scale = 0;
 	free_page_tables(get_base(current->ldt[1]), get_limit(0x0f));
 	free_page_tables(get_base(current->ldt[2]), get_limit(0x17));
 
@@ -595,6 +602,9 @@ restart_interp:
 
 	// 堆栈指针
 	eip[3] = p; /* stack pointer */
+
+	// 启动过程中执行 /etc/rc 和登录 shell 等程序的时间
+	boot_stamp("execve");
 	return 0;
 exec_error2:
 	iput(inode);
@@ -104,9 +104,19 @@ int sys_fcntl(unsigned int fd, unsigned int cmd, unsigned long arg)
 
 	// 设置文件状态和访问模式(根据 arg 设置添加、非阻塞标志)
 	case F_SETFL:
-		filp->f_flags &= ~(O_APPEND | O_NONBLOCK);
-		filp->f_flags |= arg & (O_APPEND | O_NONBLOCK);
+		filp->f_flags &= ~(O_APPEND | O_NONBLOCK | O_DIRECT);
+		filp->f_flags |= arg & (O_APPEND | O_NONBLOCK | O_DIRECT);
 		return 0;
+
+	// 设置和读取管道缓冲区的大小（字节数）
+	case F_SETPIPE_SZ:
+	case F_GETPIPE_SZ:
+		if (!filp->f_inode || !filp->f_inode->i_pipe)
+			return -EBADF;
+		if (cmd == F_GETPIPE_SZ)
+			return PIPE_BUF_SIZE(*filp->f_inode);
+		return pipe_resize(filp->f_inode, arg);
+
 	// 以下未实现
 	case F_GETLK:
 	case F_SETLK:
@@ -267,19 +267,29 @@ void iput(struct m_inode *inode)
 
 	// 如果是管道 i 节点，则唤醒等待该管道的进程，引用次数减 1，如果还有引用则返回
 	// 否则释放管道占用的内存页面，并复位该节点的引用计数值、已修改标志和管道标志，并返回
-	// 对于 pipe 节点，inode->i_size 存放着物理内存页地址
+	// 对于 pipe 节点，inode->i_size 和 i_zone[2..8] 存放着缓冲区各页面的地址
 	if (inode->i_pipe)
 	{
 		wake_up(&inode->i_wait);
 		if (--inode->i_count)
 			return;
-		free_page(inode->i_size);
+		free_pipe(inode);
 		inode->i_count = 0;
 		inode->i_dirt = 0;
 		inode->i_pipe = 0;
 		return;
 	}
 
+	// 如果是套接字 i 节点，引用次数减 1，最后一次引用被放回时释放套接字
+	// 先清除套接字标志，释放套接字时可能睡眠，此时该 i 节点已经可以被重新使用
+	if (inode->i_sock)
+	{
+		if (--inode->i_count)
+			return;
+		sock_release(inode);
+		return;
+	}
+
 	// 如果 i 节点对应的设备号=0，则将此节点的引用计数递减 1，返回
 	if (!inode->i_dev)
 	{
@@ -287,6 +297,18 @@ void iput(struct m_inode *inode)
 		return;
 	}
 
+	// proc 伪文件系统的 i 节点，最后一次引用被放回时使之失效
+	// 进程目录的 i 节点号由任务槽决定，不能让以后同一槽中的新进程取到这个缓存的 i 节点
+	if (inode->i_dev == PROC_DEV)
+	{
+		if (--inode->i_count)
+			return;
+		inode->i_dev = 0;
+		inode->i_num = 0;
+		inode->i_dirt = 0;
+		return;
+	}
+
 	// 如果是块设备文件的 i 节点，此时逻辑块字段 0 中是设备号
 	// 则刷新该设备，并等待 i 节点解锁
 	if (S_ISBLK(inode->i_mode))
@@ -397,7 +419,7 @@ struct m_inode *get_pipe_inode(void)
 	if (!(inode = get_empty_inode()))
 		return NULL;
 
-	// 节点的 i_size 字段指向缓冲区，如果已没有空闲内存
+	// 节点的 i_size 字段指向缓冲区（开始时只有 1 页），如果已没有空闲内存
 	if (!(inode->i_size = get_free_page()))
 	{
 		// 则释放该 i 节点，并返回 NULL
@@ -508,7 +530,14 @@ static void read_inode(struct m_inode *inode)
 	int block;
 
 	// 首先锁定该 i 节点，取该节点所在设备的超级块
+	// proc 伪文件系统的 i 节点不在设备上，由 proc_read_inode() 生成
 	lock_inode(inode);
+	if (inode->i_dev == PROC_DEV)
+	{
+		proc_read_inode(inode);
+		unlock_inode(inode);
+		return;
+	}
 	if (!(sb = get_super(inode->i_dev)))
 		panic("trying to read inode without dev");
 
@@ -538,9 +567,11 @@ static void write_inode(struct m_inode *inode)
 
 	// 首先锁定该 i 节点，如果该 i 节点没有被修改过
 	// 或者该 i 节点的设备号等于零，则解锁该 i 节点，并退出
+	// proc 伪文件系统的 i 节点不写回，修改（如 chmod）只在内存中有效
 	lock_inode(inode);
-	if (!inode->i_dirt || !inode->i_dev)
+	if (!inode->i_dirt || !inode->i_dev || inode->i_dev == PROC_DEV)
 	{
+		inode->i_dirt = 0;
 		unlock_inode(inode);
 		return;
 	}
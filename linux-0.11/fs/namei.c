@@ -50,6 +50,10 @@ static int permission(struct m_inode *inode, int mask)
 	if (inode->i_dev && !inode->i_nlinks)
 		return 0;
 
+	// proc 伪文件系统是只读的，超级用户也不能写其中的文件或在其中建立、删除目录项
+	if (inode->i_dev == PROC_DEV && (mask & MAY_WRITE))
+		return 0;
+
 	// 否则，如果进程的有效用户 id(euid) 与 i 节点的用户 id 相同
 	// 则取文件宿主的用户访问权限
 	else if (current->euid == inode->i_uid)
@@ -175,6 +179,19 @@ static struct buffer_head *find_entry(
 		}
 	}
 
+	// proc 伪文件系统的目录没有数据块，由 proc_lookup() 查找
+	// 找到的目录项放在该目录项 i 节点号对应的、不属于任何真实设备的缓冲块中
+	// 同一个 i 节点号的目录项内容总是相同的，因此多个进程同时使用这个缓冲块也没有关系
+	if ((*dir)->i_dev == PROC_DEV)
+	{
+		if (!(i = proc_lookup(*dir, name, namelen)) || !(bh = getblk(PROC_DEV, i)))
+			return NULL;
+		de = (struct dir_entry *)bh->b_data;
+		de->inode = i;
+		*res_dir = de;
+		return bh;
+	}
+
 	// 如果该 i 节点所指向的第一个直接磁盘块号为 0，则返回 NULL，退出
 	if (!(block = (*dir)->i_zone[0]))
 		return NULL;
@@ -654,6 +671,16 @@ int open_namei(const char *pathname, int flag, int mode,
 // dev - 设备号；
 // 返回：成功则返回0，否则返回出错码。
 int sys_mknod(const char *filename, int mode, int dev)
+{
+	// 如果不是超级用户，则返回访问许可出错码
+	if (!suser())
+		return -EPERM;
+	return do_mknod(filename, mode, dev);
+}
+
+// 创建文件系统节点，参数和返回值与 sys_mknod() 相同，但不检查调用者是否是超级用户
+// 绑定 UNIX 域套接字时用它建立套接字的名字节点
+int do_mknod(const char *filename, int mode, int dev)
 {
 	const char *basename;
 	int namelen;
@@ -661,10 +688,6 @@ int sys_mknod(const char *filename, int mode, int dev)
 	struct buffer_head *bh;
 	struct dir_entry *de;
 
-	// 如果不是超级用户，则返回访问许可出错码
-	if (!suser())
-		return -EPERM;
-
 	// 如果找不到对应路径名目录的 i 节点，则返回出错码
 	if (!(dir = dir_namei(filename, &namelen, &basename)))
 		return -ENOENT;
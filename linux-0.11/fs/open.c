@@ -262,11 +262,19 @@ int sys_open(const char *filename, int flag, int mode)
 	// ttys 有些特殊，ttyxx 主号==4，tty 主号==5
 	// 如果是字符设备文件，那么如果设备号是 4 的话，则设置当前进程的 tty 号为该i 节点的子设备号
 	// 并设置当前进程tty 对应的 tty 表项的父进程组号等于进程的父进程组号
+	// 伪终端先由 pty_open() 分配或检查，主端不能成为控制终端
 	if (S_ISCHR(inode->i_mode))
 	{
 		if (MAJOR(inode->i_zone[0]) == 4)
 		{
-			if (current->leader && current->tty < 0)
+			if ((i = pty_open(MINOR(inode->i_zone[0]))) < 0)
+			{
+				iput(inode);
+				current->filp[fd] = NULL;
+				f->f_count = 0;
+				return i;
+			}
+			if (current->leader && current->tty < 0 && MINOR(inode->i_zone[0]) < NR_TTY)
 			{
 				current->tty = MINOR(inode->i_zone[0]);
 				tty_table[current->tty].pgrp = current->pgrp;
@@ -338,6 +346,10 @@ int sys_close(unsigned int fd)
 	// 若已等于 0，说明该文件已经没有句柄引用，则释放该文件 i 节点，返回 0
 	if (--filp->f_count)
 		return (0);
+
+	// 伪终端主端的最后一次关闭挂断该伪终端
+	if (S_ISCHR(filp->f_inode->i_mode) && MAJOR(filp->f_inode->i_zone[0]) == 4)
+		pty_close(MINOR(filp->f_inode->i_zone[0]));
 	iput(filp->f_inode);
 	return (0);
 }
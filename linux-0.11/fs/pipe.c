@@ -5,57 +5,79 @@
  */
 
 #include <signal.h>
+#include <errno.h>
+#include <string.h>
 
 #include <linux/sched.h>
 #include <linux/mm.h> /* for get_free_page */
 #include <asm/segment.h>
 
+// 管道中可以写入的字节数（为区分空和满，缓冲区中总要空出 1 个字节）
+#define PIPE_FREE(inode) (PIPE_BUF_SIZE(inode) - 1 - PIPE_SIZE(inode))
+
+// 唤醒门限：写管道者要等到空闲空间达到缓冲区的一半（或足以写完剩下的数据）时才继续写，
+// 读管道者也只在空闲空间达到这个门限时才唤醒写管道者
+// 这样读写双方每切换一次都能成批地传送数据，而不是腾出几个字节就切换一次
+#define PIPE_THRESHOLD(inode) (PIPE_BUF_SIZE(inode) / 2)
+
+// 让用户缓冲区 buf 开始的最多一页（count 字节）范围内的页面存在
+// 这样随后的复制不会因为缺页而睡眠，复制期间管道的状态和缓冲区页面不会被其它进程改变
+static inline void pipe_fault_in(char *buf, int count)
+{
+	if (count > PAGE_SIZE)
+		count = PAGE_SIZE;
+	(void)get_fs_byte(buf);
+	(void)get_fs_byte(buf + count - 1);
+}
+
 // 管道读操作函数
 // 参数 inode 是管道对应的 i 节点，buf 是数据缓冲区指针，count 是读取的字节数
+// 管道中没有数据时，如果已经读到了一些数据则立即返回，否则睡眠等待写管道者
 int read_pipe(struct m_inode *inode, char *buf, int count)
 {
-	int chars, size, read = 0;
+	int chars, size, tail, read = 0;
 
 	// 若欲读取的字节计数值 count 大于 0，则循环执行以下操作
 	while (count > 0)
 	{
-		// 若当前管道中没有数据(size=0)，则唤醒等待该节点的进程
-		// 如果已没有写管道者，则返回已读字节数，退出
+		// 若当前管道中没有数据(size=0)，并且已经读到数据或已没有写管道者，则返回已读字节数
 		// 否则在该 i 节点上睡眠，等待信息
+		// 写管道者在睡眠之前和写完之后都会唤醒读管道者，因此这里不必唤醒写管道者
 		while (!(size = PIPE_SIZE(*inode)))
 		{
-			wake_up(&inode->i_wait);
-			if (inode->i_count != 2) /* are there any writers? */
+			if (read || inode->i_count != 2) /* are there any writers? */
 				return read;
 			sleep_on(&inode->i_wait);
 		}
 
-		// 取管道尾到缓冲区末端的字节数 chars
+		// 先让用户缓冲区页面存在，缺页处理时可能睡眠，因此之后要重新取管道中的数据长度
+		pipe_fault_in(buf, count);
+		if (!(size = PIPE_SIZE(*inode)))
+			continue;
+
+		// 取管道尾到所在页面末端的字节数 chars
 		// 如果其大于还需要读取的字节数 count，则令其等于 count
 		// 如果 chars 大于当前管道中含有数据的长度 size，则令其等于 size
-		chars = PAGE_SIZE - PIPE_TAIL(*inode);
+		tail = PIPE_TAIL(*inode);
+		chars = PAGE_SIZE - (tail & (PAGE_SIZE - 1));
 		if (chars > count)
 			chars = count;
 		if (chars > size)
 			chars = size;
 
-		// 读字节计数减去此次可读的字节数 chars，并累加已读字节数
+		// 将管道中的数据成块复制到用户缓冲区中，然后再调整管道尾指针（前移 chars 字节）
+		memcpy_tofs(buf, (char *)PIPE_PAGE(*inode, tail / PAGE_SIZE) + (tail & (PAGE_SIZE - 1)), chars);
+		PIPE_TAIL(*inode) = (tail + chars) & (PIPE_BUF_SIZE(*inode) - 1);
+
+		// 读字节计数减去此次读取的字节数 chars，并累加已读字节数
+		buf += chars;
 		count -= chars;
 		read += chars;
-
-		// 令 size 指向管道尾部，调整当前管道尾指针（前移 chars 字节）
-		size = PIPE_TAIL(*inode);
-		PIPE_TAIL(*inode) += chars;
-		PIPE_TAIL(*inode) &= (PAGE_SIZE - 1);
-
-		// 将管道中的数据复制到用户缓冲区中
-		// 对于管道 i 节点，其 i_size 字段中是管道缓冲块指针
-		while (chars-- > 0)
-			put_fs_byte(((char *)inode->i_size)[size++], buf++);
 	}
 
-	// 唤醒等待该管道 i 节点的进程，并返回读取的字节数
-	wake_up(&inode->i_wait);
+	// 空闲空间达到唤醒门限时才唤醒等待该管道的写管道者，并返回读取的字节数
+	if (PIPE_FREE(*inode) >= PIPE_THRESHOLD(*inode))
+		wake_up(&inode->i_wait);
 	return read;
 }
 
@@ -63,14 +85,14 @@ int read_pipe(struct m_inode *inode, char *buf, int count)
 // 参数 inode 是管道对应的 i 节点，buf 是数据缓冲区指针，count 是将写入管道的字节数
 int write_pipe(struct m_inode *inode, char *buf, int count)
 {
-	int chars, size, written = 0;
+	int chars, size, head, written = 0;
 
 	// 若将写入的字节计数值 count 还大于 0，则循环执行以下操作
 	while (count > 0)
 	{
-		while (!(size = (PAGE_SIZE - 1) - PIPE_SIZE(*inode)))
+		while ((size = PIPE_FREE(*inode)) < count && size < PIPE_THRESHOLD(*inode))
 		{
-			// 若当前管道中没有已经满了(size=0)，则唤醒等待该节点的进程
+			// 若当前管道中的空闲空间既不够写完剩下的数据，也没有达到唤醒门限，则唤醒等待该节点的进程
 			// 如果已没有读管道者，则向进程发送 SIGPIPE 信号
 			// 并返回已写入的字节数并退出
 			// 若写入 0 字节，则返回 -1
@@ -84,33 +106,98 @@ int write_pipe(struct m_inode *inode, char *buf, int count)
 			sleep_on(&inode->i_wait);
 		}
 
-		// 取管道头部到缓冲区末端空间字节数 chars
+		// 先让用户缓冲区页面存在，缺页处理时可能睡眠，因此之后要重新取管道中的空闲空间
+		pipe_fault_in(buf, count);
+		if (!(size = PIPE_FREE(*inode)))
+			continue;
+
+		// 取管道头部到所在页面末端的空间字节数 chars
 		// 如果其大于还需要写入的字节数 count，则令其等于 count
 		// 如果 chars 大于当前管道中空闲空间长度 size，则令其等于 size
-		chars = PAGE_SIZE - PIPE_HEAD(*inode);
+		head = PIPE_HEAD(*inode);
+		chars = PAGE_SIZE - (head & (PAGE_SIZE - 1));
 		if (chars > count)
 			chars = count;
 		if (chars > size)
 			chars = size;
 
-		// 写入字节计数减去此次可写入的字节数 chars，并累加已写字节数到 written
+		// 从用户缓冲区成块复制 chars 个字节到管道中，然后再调整管道头指针（前移 chars 字节）
+		memcpy_fromfs((char *)PIPE_PAGE(*inode, head / PAGE_SIZE) + (head & (PAGE_SIZE - 1)), buf, chars);
+		PIPE_HEAD(*inode) = (head + chars) & (PIPE_BUF_SIZE(*inode) - 1);
+
+		// 写入字节计数减去此次写入的字节数 chars，并累加已写字节数到 written
+		buf += chars;
 		count -= chars;
 		written += chars;
+	}
+
+	// 唤醒等待该 i 节点的读管道者，返回已写入的字节数，退出
+	wake_up(&inode->i_wait);
+	return written;
+}
+
+// 修改管道缓冲区的大小为 size 字节，页面数按 2 的幂向上取整
+// 管道中已有的数据被复制到新的缓冲区中，新缓冲区必须能容纳这些数据
+// 返回：新的缓冲区大小，出错则返回出错码
+int pipe_resize(struct m_inode *inode, unsigned long size)
+{
+	unsigned long page[PIPE_MAX_PAGES];
+	int pages, count, chars, tail, i;
+
+	if (!size || size > PIPE_MAX_PAGES * PAGE_SIZE)
+		return -EINVAL;
+	for (pages = 1; pages * PAGE_SIZE < size; pages <<= 1)
+		;
+	if (pages == PIPE_PAGES(*inode))
+		return pages * PAGE_SIZE;
+	if ((count = PIPE_SIZE(*inode)) >= pages * PAGE_SIZE)
+		return -EBUSY;
 
-		// 令 size 指向管道数据头部，调整当前管道数据头部指针（前移 chars 字节）
-		size = PIPE_HEAD(*inode);
-		PIPE_HEAD(*inode) += chars;
-		PIPE_HEAD(*inode) &= (PAGE_SIZE - 1);
+	// 先取得全部新页面，任何一页取不到就放弃修改
+	for (i = 0; i < pages; i++)
+		if (!(page[i] = get_free_page()))
+		{
+			while (i--)
+				free_page(page[i]);
+			return -ENOMEM;
+		}
 
-		// 从用户缓冲区复制 chars 个字节到管道中
-		// 对于管道 i 节点，其 i_size 字段中是管道缓冲块指针
-		while (chars-- > 0)
-			((char *)inode->i_size)[size++] = get_fs_byte(buf++);
+	// 把管道中的数据按顺序复制到新缓冲区的开始处
+	// 复制过程不会睡眠，因此其它进程看不到中间状态
+	tail = PIPE_TAIL(*inode);
+	for (i = 0; i < count; i += chars)
+	{
+		chars = PAGE_SIZE - (tail & (PAGE_SIZE - 1));
+		if (chars > PAGE_SIZE - (i & (PAGE_SIZE - 1)))
+			chars = PAGE_SIZE - (i & (PAGE_SIZE - 1));
+		if (chars > count - i)
+			chars = count - i;
+		memcpy((char *)page[i / PAGE_SIZE] + (i & (PAGE_SIZE - 1)),
+			   (char *)PIPE_PAGE(*inode, tail / PAGE_SIZE) + (tail & (PAGE_SIZE - 1)), chars);
+		tail = (tail + chars) & (PIPE_BUF_SIZE(*inode) - 1);
 	}
 
-	// 唤醒等待该 i 节点的进程，返回已写入的字节数，退出
+	// 释放原来的页面，换上新的页面
+	free_pipe(inode);
+	inode->i_size = page[0];
+	for (i = 1; i < PIPE_MAX_PAGES; i++)
+		inode->i_zone[i + 1] = (i < pages) ? (page[i] >> 12) : 0;
+	PIPE_PAGES(*inode) = pages;
+	PIPE_TAIL(*inode) = 0;
+	PIPE_HEAD(*inode) = count;
+
+	// 缓冲区变大后可能有写管道者可以继续写了
 	wake_up(&inode->i_wait);
-	return written;
+	return pages * PAGE_SIZE;
+}
+
+// 释放管道缓冲区的全部页面，在管道 i 节点被释放时调用
+void free_pipe(struct m_inode *inode)
+{
+	int i;
+
+	for (i = 0; i < PIPE_PAGES(*inode); i++)
+		free_page(PIPE_PAGE(*inode, i));
 }
 
 // 创建管道系统调用函数
@@ -0,0 +1,341 @@
+/*
+ *  linux/fs/proc.c
+ */
+
+// proc 伪文件系统，以文件的形式提供进程和内核的状态，供 ps、top 之类的程序读取
+// 它不在任何磁盘上：设备号 PROC_DEV 没有对应的块设备驱动，超级块、i 节点和目录内容都是在使用时生成的
+// 用法：mknod /dev/proc b 0 1; mount /dev/proc /proc
+//
+// 目录结构及 i 节点号：
+//   /            1      根目录
+//   meminfo      2      主内存区页面的使用情况
+//   blkstat      3      高速缓冲和块设备统计，即 /dev/blkstat 的文本形式
+//   uptime       4      开机以来的秒数
+//   bootlog      5      启动过程各阶段的时间，见 include/linux/bootlog.h
+//   <pid>/       (n+1)<<4       任务槽 n 中的进程，目录名是进程号
+//   <pid>/stat   (n+1)<<4 | 1   进程状态，一行以空格分隔的数字，便于程序解析
+//   <pid>/status (n+1)<<4 | 2   进程状态，每行一项
+// 进程目录的 i 节点中记录了进程号（i_pid，bmap() 等读写数据块的函数不会用到它），任务槽被新进程重用后，
+// 仍然打开着的旧 i 节点读出的内容为空
+// 所有文件都是只读的：permission() 拒绝对 proc 中 i 节点的写访问（包括超级用户），
+// 因此不会有进程在这里建立或删除目录项
+
+#include <errno.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/bootlog.h>
+#include <asm/segment.h>
+
+extern int vsprintf(char *buf, const char *fmt, va_list args);
+
+#define PROC_MEMINFO 2
+#define PROC_BLKSTAT 3
+#define PROC_UPTIME 4
+#define PROC_BOOTLOG 5
+
+// 进程目录中的文件
+#define PROC_PID_STAT 1
+#define PROC_PID_STATUS 2
+
+#define PROC_SLOT(ino) (((ino) >> 4) - 1)
+#define PROC_FILE(ino) ((ino)&15)
+
+// 根目录中的文件
+static struct
+{
+	int ino;
+	const char *name;
+} proc_root_files[] = {
+	{PROC_MEMINFO, "meminfo"},
+	{PROC_BLKSTAT, "blkstat"},
+	{PROC_UPTIME, "uptime"},
+	{PROC_BOOTLOG, "bootlog"},
+	{0, NULL}};
+
+// 进程目录中的文件
+static const char *proc_pid_files[] = {NULL, "stat", "status", NULL};
+
+static int sprintf(char *buf, const char *fmt, ...)
+{
+	va_list args;
+	int i;
+
+	va_start(args, fmt);
+	i = vsprintf(buf, fmt, args);
+	va_end(args);
+	return i;
+}
+
+// 取 proc i 节点对应的进程，进程已经退出（任务槽为空或已被其它进程使用）时返回 NULL
+static struct task_struct *proc_task(struct m_inode *inode)
+{
+	struct task_struct *p;
+	int n = PROC_SLOT(inode->i_num);
+
+	if (n < 0 || n >= NR_TASKS || !(p = task[n]) || p->pid != inode->i_pid)
+		return NULL;
+	return p;
+}
+
+// 安装 proc 文件系统时由 read_super() 调用，填写超级块 s 中需要的字段
+// proc 没有 i 节点位图和逻辑块位图
+void proc_read_super(struct super_block *s)
+{
+	int i;
+
+	for (i = 0; i < I_MAP_SLOTS; i++)
+		s->s_imap[i] = NULL;
+	for (i = 0; i < Z_MAP_SLOTS; i++)
+		s->s_zmap[i] = NULL;
+	s->s_ninodes = (NR_TASKS + 1) << 4;
+	s->s_nzones = 0;
+	s->s_imap_blocks = s->s_zmap_blocks = 0;
+	s->s_firstdatazone = 0;
+	s->s_log_zone_size = 0;
+	s->s_max_size = 0;
+	s->s_magic = 0;
+}
+
+// 生成 proc i 节点的内容，由 read_inode() 调用，i 节点中其余字段已经清零
+void proc_read_inode(struct m_inode *inode)
+{
+	struct task_struct *p;
+	int n = inode->i_num;
+
+	inode->i_mtime = inode->i_atime = inode->i_ctime = CURRENT_TIME;
+	inode->i_nlinks = 1;
+	if (n == ROOT_INO)
+	{
+		inode->i_mode = S_IFDIR | 0555;
+		inode->i_nlinks = 2;
+		return;
+	}
+	if (n < 16)
+	{
+		inode->i_mode = S_IFREG | 0444;
+		return;
+	}
+
+	// 进程目录和其中的文件，属于进程的有效用户
+	inode->i_mode = PROC_FILE(n) ? (S_IFREG | 0444) : (S_IFDIR | 0555);
+	if (!PROC_FILE(n))
+		inode->i_nlinks = 2;
+	n = PROC_SLOT(n);
+	if (n < 0 || n >= NR_TASKS || !(p = task[n]))
+		return;
+	inode->i_uid = p->euid;
+	inode->i_gid = p->egid;
+	inode->i_pid = p->pid;
+}
+
+// 比较用户空间中长度为 len 的名字 name 与内核中的字符串 s
+static int proc_match(const char *name, int len, const char *s)
+{
+	while (len-- > 0)
+		if (get_fs_byte(name++) != *s++)
+			return 0;
+	return !*s;
+}
+
+// 在 proc 目录 dir 中查找名字为 name（在用户空间中）的目录项，由 find_entry() 调用
+// 返回：目录项的 i 节点号，没有找到返回 0
+int proc_lookup(struct m_inode *dir, const char *name, int namelen)
+{
+	struct task_struct *p;
+	long pid = 0;
+	int i, c;
+
+	if (proc_match(name, namelen, "."))
+		return dir->i_num;
+	if (proc_match(name, namelen, ".."))
+		return ROOT_INO;
+
+	// 进程目录中的文件
+	if (dir->i_num != ROOT_INO)
+	{
+		if (!proc_task(dir))
+			return 0;
+		for (i = 1; proc_pid_files[i]; i++)
+			if (proc_match(name, namelen, proc_pid_files[i]))
+				return dir->i_num | i;
+		return 0;
+	}
+
+	// 根目录中的文件，或者以进程号为名的进程目录
+	for (i = 0; proc_root_files[i].name; i++)
+		if (proc_match(name, namelen, proc_root_files[i].name))
+			return proc_root_files[i].ino;
+	if (namelen <= 0 || namelen > 9)
+		return 0;
+	for (i = 0; i < namelen; i++)
+	{
+		c = get_fs_byte(name + i);
+		if (c < '0' || c > '9')
+			return 0;
+		pid = pid * 10 + c - '0';
+	}
+	for (i = 0; i < NR_TASKS; i++)
+		if ((p = task[i]) && p->pid == pid)
+			return (i + 1) << 4;
+	return 0;
+}
+
+// 在 de 处填写一个目录项
+static void proc_dir_entry(struct dir_entry *de, int ino, const char *name)
+{
+	int i;
+
+	de->inode = ino;
+	for (i = 0; i < NAME_LEN && name[i]; i++)
+		de->name[i] = name[i];
+	for (; i < NAME_LEN; i++)
+		de->name[i] = 0;
+}
+
+// 生成目录 dir 的内容（minix 格式的目录项数组）到 buf 中
+// 返回：内容的字节数
+static int proc_readdir(struct m_inode *dir, char *buf)
+{
+	struct dir_entry *de = (struct dir_entry *)buf;
+	char name[NAME_LEN + 1];
+	int i;
+
+	proc_dir_entry(de++, dir->i_num, ".");
+	proc_dir_entry(de++, ROOT_INO, "..");
+	if (dir->i_num != ROOT_INO)
+	{
+		if (!proc_task(dir))
+			return 0;
+		for (i = 1; proc_pid_files[i]; i++)
+			proc_dir_entry(de++, dir->i_num | i, proc_pid_files[i]);
+		return (char *)de - buf;
+	}
+	for (i = 0; proc_root_files[i].name; i++)
+		proc_dir_entry(de++, proc_root_files[i].ino, proc_root_files[i].name);
+	for (i = 0; i < NR_TASKS; i++)
+		if (task[i])
+		{
+			sprintf(name, "%d", task[i]->pid);
+			proc_dir_entry(de++, (i + 1) << 4, name);
+		}
+	return (char *)de - buf;
+}
+
+// 进程状态对应的字符：运行、可中断睡眠、不可中断睡眠、僵死、停止
+static char proc_state_char(long state)
+{
+	return (state >= 0 && state <= TASK_STOPPED) ? "RSDZT"[state] : '?';
+}
+
+// 生成进程 p 的 stat 或 status 文件内容到 buf 中
+// 返回：内容的字节数
+static int proc_pid_read(struct task_struct *p, int file, char *buf)
+{
+	unsigned long pages;
+
+	// 代码段和数据段共用进程的 64MB 线性地址空间，统计其中存在的页面数
+	pages = count_pages(get_base(p->ldt[1]), 0x4000000);
+	if (file == PROC_PID_STAT)
+		return sprintf(buf, "%d %c %d %d %d %d %d %d %d %d %d %d %d %d %d %u\n",
+					   p->pid, proc_state_char(p->state), p->father, p->pgrp,
+					   p->session, p->leader, p->tty, p->counter, p->priority,
+					   p->utime, p->stime, p->cutime, p->cstime, p->start_time,
+					   p->euid, pages);
+	return sprintf(buf,
+				   "Pid:\t%d\nState:\t%c\nPPid:\t%d\nPgrp:\t%d\nSession:\t%d\n"
+				   "Uid:\t%d\t%d\t%d\nGid:\t%d\t%d\t%d\nTty:\t%d\n"
+				   "Counter:\t%d\nPriority:\t%d\nUtime:\t%d\nStime:\t%d\n"
+				   "Cutime:\t%d\nCstime:\t%d\nStart:\t%d\n"
+				   "Code:\t%u\nData:\t%u\nBrk:\t%u\nPages:\t%u\n",
+				   p->pid, proc_state_char(p->state), p->father, p->pgrp, p->session,
+				   p->uid, p->euid, p->suid, p->gid, p->egid, p->sgid, p->tty,
+				   p->counter, p->priority, p->utime, p->stime,
+				   p->cutime, p->cstime, p->start_time,
+				   p->end_code, p->end_data - p->end_code, p->brk, pages);
+}
+
+// 生成根目录中文件的内容到 buf 中
+// 返回：内容的字节数
+static int proc_root_read(int ino, char *buf)
+{
+	struct blk_stat s;
+	unsigned long total, free, shared, reserved;
+	char *p = buf;
+	int i;
+
+	switch (ino)
+	{
+	case PROC_MEMINFO:
+		mem_usage(&total, &free, &shared, &reserved);
+		return sprintf(buf, "PageSize:\t%d\nTotal:\t%u\nFree:\t%u\nShared:\t%u\nReserved:\t%u\n",
+					   PAGE_SIZE, total, free, shared, reserved);
+	case PROC_BLKSTAT:
+		get_blk_stat(&s);
+		p += sprintf(p, "getblk_hit %u\ngetblk_miss %u\nbread_wait %u\n"
+						"reada_issued %u\nreada_useful %u\n"
+						"buffer_wait %u\nrequest_wait %u\nsync %u\nsync_dev %u\n"
+						"buffers %u\ndirty %u\nlocked %u\n",
+					 s.getblk_hit, s.getblk_miss, s.bread_wait,
+					 s.reada_issued, s.reada_useful,
+					 s.buffer_wait, s.request_wait, s.sync, s.sync_dev,
+					 s.nr_buffers, s.nr_dirty, s.nr_locked);
+		p += sprintf(p, "requests");
+		for (i = 0; i < NR_BLK_STAT; i++)
+			p += sprintf(p, " %u", s.requests[i]);
+		p += sprintf(p, "\nqueue");
+		for (i = 0; i < NR_BLK_STAT; i++)
+			p += sprintf(p, " %u", s.queue_depth[i]);
+		p += sprintf(p, "\n");
+		return p - buf;
+	case PROC_UPTIME:
+		return sprintf(buf, "%d.%02d\n", jiffies / HZ, jiffies % HZ);
+	case PROC_BOOTLOG:
+		// 每行：距引导开始的毫秒数、滴答数、进程号、阶段名，无法换算的时间为 -1
+		// 实模式阶段的时间精度约为 55 毫秒，也没有滴答数和进程号
+		p += sprintf(p, "ms jiffies pid phase\n");
+		if (boot_bios_ms[0] >= 0)
+			for (i = 0; i < NR_BOOT_BIOS; i++)
+				p += sprintf(p, "%d - - %s\n", boot_bios_ms[i], boot_bios_name[i]);
+		for (i = 0; i < nr_boot_stamps; i++)
+			p += sprintf(p, "%d %d %d %s\n", boot_ms(i), boot_log[i].jiffies,
+						 boot_log[i].pid, boot_log[i].name);
+		return p - buf;
+	}
+	return 0;
+}
+
+// 读 proc 文件或目录，由 read_file() 调用
+// 每次读都重新生成整个文件的内容（不超过一页），再从 f_pos 处复制给用户
+// 返回：读出的字节数，出错返回出错码
+int proc_read(struct m_inode *inode, struct file *filp, char *buf, int count)
+{
+	struct task_struct *p;
+	char *page;
+	int len;
+
+	if (count <= 0)
+		return 0;
+	if (!(page = (char *)get_free_page()))
+		return -ENOMEM;
+	if (S_ISDIR(inode->i_mode))
+		len = proc_readdir(inode, page);
+	else if (inode->i_num < 16)
+		len = proc_root_read(inode->i_num, page);
+	else if ((p = proc_task(inode)))
+		len = proc_pid_read(p, PROC_FILE(inode->i_num), page);
+	else
+		len = 0;
+
+	if (filp->f_pos >= len)
+		count = 0;
+	else if (count > len - filp->f_pos)
+		count = len - filp->f_pos;
+	memcpy_tofs(buf, page + filp->f_pos, count);
+	filp->f_pos += count;
+	free_page((unsigned long)page);
+	return count;
+}
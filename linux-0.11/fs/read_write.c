@@ -6,7 +6,9 @@
 
 #include <sys/stat.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <linux/kernel.h>
 #include <linux/sched.h>
@@ -35,6 +37,9 @@ extern int file_read(struct m_inode *inode, struct file *filp,
 extern int file_write(struct m_inode *inode, struct file *filp,
 					  char *buf, int count);
 
+// 直接读写函数（O_DIRECT）
+extern int direct_rw(int rw, struct file *file, char *buf, int count);
+
 // 重定位文件读写指针系统调用函数
 // 参数 fd 是文件句柄，offset 是新的文件读写指针偏移值
 // origin 是偏移的起始位置，是下列三者之一
@@ -55,8 +60,8 @@ int sys_lseek(unsigned int fd, off_t offset, int origin)
 		!IS_SEEKABLE(MAJOR(file->f_inode->i_dev)))
 		return -EBADF;
 
-	// 如果文件对应的 i 节点是管道节点，则返回出错码，退出；管道头尾指针不可随意移动！
-	if (file->f_inode->i_pipe)
+	// 如果文件对应的 i 节点是管道节点或套接字，则返回出错码，退出；管道头尾指针不可随意移动！
+	if (file->f_inode->i_pipe || file->f_inode->i_sock)
 		return -ESPIPE;
 
 	// 根据设置的定位标志，分别重新定位文件读写指针
@@ -98,26 +103,12 @@ int sys_lseek(unsigned int fd, off_t offset, int origin)
 	return file->f_pos;
 }
 
-// 读文件系统调用函数
-// 参数 fd 是文件句柄，buf 是缓冲区，count 是欲读字节数
-int sys_read(unsigned int fd, char *buf, int count)
+// 按文件类型执行读操作，sys_read()、sys_readv() 和 sys_pread() 共用
+// 调用者已经验证过缓冲区 buf
+static int read_file(struct file *file, char *buf, int count)
 {
-	struct file *file;
 	struct m_inode *inode;
 
-	// 如果文件句柄值大于程序最多打开文件数 NR_OPEN
-	// 或者需要读取的字节计数值小于 0
-	// 或者该句柄的文件结构指针为空，则返回出错码并退出
-	if (fd >= NR_OPEN || count < 0 || !(file = current->filp[fd]))
-		return -EINVAL;
-
-	// 若需读取的字节数 count 等于 0，则返回 0，退出
-	if (!count)
-		return 0;
-
-	// 验证存放数据的缓冲区内存限制
-	verify_area(buf, count);
-
 	// 取文件对应的 i 节点
 	// 若是管道文件，并且是读管道文件模式，则进行读管道操作
 	// 若成功则返回读取的字节数，否则返回出错码，退出
@@ -125,6 +116,19 @@ int sys_read(unsigned int fd, char *buf, int count)
 	if (inode->i_pipe)
 		return (file->f_mode & 1) ? read_pipe(inode, buf, count) : -EIO;
 
+	// UNIX 域套接字从自己的接收缓冲区读
+	if (inode->i_sock)
+		return sock_read(inode, buf, count);
+
+	// proc 伪文件系统的文件和目录，内容是生成的
+	if (inode->i_dev == PROC_DEV)
+		return proc_read(inode, file, buf, count);
+
+	// 以 O_DIRECT 方式打开的常规文件和块设备，不经过高速缓冲直接读（只限用户缓冲区）
+	if ((file->f_flags & O_DIRECT) && get_fs() == 0x17 &&
+		(S_ISREG(inode->i_mode) || S_ISBLK(inode->i_mode)))
+		return direct_rw(READ, file, buf, count);
+
 	// 如果是字符型文件，则进行读字符设备操作，返回读取的字符数
 	if (S_ISCHR(inode->i_mode))
 		return rw_char(READ, inode->i_zone[0], buf, count, &file->f_pos);
@@ -152,22 +156,34 @@ int sys_read(unsigned int fd, char *buf, int count)
 	return -EINVAL;
 }
 
-// 写文件系统调用函数
-// 参数 fd 是文件句柄，buf 是缓冲区，count 是欲写字节数
-int sys_write(unsigned int fd, char *buf, int count)
+// 读文件系统调用函数
+// 参数 fd 是文件句柄，buf 是缓冲区，count 是欲读字节数
+int sys_read(unsigned int fd, char *buf, int count)
 {
 	struct file *file;
-	struct m_inode *inode;
 
 	// 如果文件句柄值大于程序最多打开文件数 NR_OPEN
-	// 或者需要写入的字节计数小于0，或者该句柄的文件结构指针为空，则返回出错码并退出
+	// 或者需要读取的字节计数值小于 0
+	// 或者该句柄的文件结构指针为空，则返回出错码并退出
 	if (fd >= NR_OPEN || count < 0 || !(file = current->filp[fd]))
 		return -EINVAL;
 
-	// 若需读取的字节数 count 等于0，则返回 0，退出
+	// 若需读取的字节数 count 等于 0，则返回 0，退出
 	if (!count)
 		return 0;
 
+	// 验证存放数据的缓冲区内存限制
+	verify_area(buf, count);
+
+	return read_file(file, buf, count);
+}
+
+// 按文件类型执行写操作，sys_write() 和 sys_sendfile() 共用
+// buf 是 fs 段中的地址，sys_sendfile() 调用时 fs 指向内核数据段
+static int write_file(struct file *file, char *buf, int count)
+{
+	struct m_inode *inode;
+
 	// 取文件对应的 i 节点
 	// 若是管道文件，并且是写管道文件模式，则进行写管道操作
 	// 若成功则返回写入的字节数，否则返回出错码，退出
@@ -175,6 +191,19 @@ int sys_write(unsigned int fd, char *buf, int count)
 	if (inode->i_pipe)
 		return (file->f_mode & 2) ? write_pipe(inode, buf, count) : -EIO;
 
+	// UNIX 域套接字写到对方的接收缓冲区
+	if (inode->i_sock)
+		return sock_write(inode, buf, count);
+
+	// proc 文件系统中的文件是只读的，即使描述符是以只读方式打开的也不能写
+	if (inode->i_dev == PROC_DEV)
+		return -EROFS;
+
+	// 以 O_DIRECT 方式打开的常规文件和块设备，不经过高速缓冲直接写（只限用户缓冲区）
+	if ((file->f_flags & O_DIRECT) && get_fs() == 0x17 &&
+		(S_ISREG(inode->i_mode) || S_ISBLK(inode->i_mode)))
+		return direct_rw(WRITE, file, buf, count);
+
 	// 如果是字符型文件，则进行写字符设备操作，返回写入的字符数，退出
 	if (S_ISCHR(inode->i_mode))
 		return rw_char(WRITE, inode->i_zone[0], buf, count, &file->f_pos);
@@ -191,3 +220,244 @@ int sys_write(unsigned int fd, char *buf, int count)
 	printk("(Write)inode->i_mode=%06o\n\r", inode->i_mode);
 	return -EINVAL;
 }
+
+// 写文件系统调用函数
+// 参数 fd 是文件句柄，buf 是缓冲区，count 是欲写字节数
+int sys_write(unsigned int fd, char *buf, int count)
+{
+	struct file *file;
+
+	// 如果文件句柄值大于程序最多打开文件数 NR_OPEN
+	// 或者需要写入的字节计数小于0，或者该句柄的文件结构指针为空，则返回出错码并退出
+	if (fd >= NR_OPEN || count < 0 || !(file = current->filp[fd]))
+		return -EINVAL;
+
+	// 若需读取的字节数 count 等于0，则返回 0，退出
+	if (!count)
+		return 0;
+
+	return write_file(file, buf, count);
+}
+
+// 文件中的空洞没有对应的数据块，sys_sendfile() 从这里取 0 数据
+static char zero_block[BLOCK_SIZE] = {
+	0,
+};
+
+// 系统调用 sendfile()，把文件 in_fd 中的数据直接送到文件 out_fd 中
+// in_fd 必须是常规文件或块设备，out_fd 可以是管道、字符设备(tty)、块设备或常规文件
+// 数据从高速缓冲块直接交给 write_pipe()/tty_write()/file_write() 等写函数，
+// 不再经过用户缓冲区，每个字节只复制一次
+// 参数多于 3 个，因此通过用户空间中的参数块 args 传递：
+// args[0] - out_fd；args[1] - in_fd；
+// args[2] - 读取位置指针 off_t *offset，为 NULL 则使用并更新 in_fd 的读写指针；
+// args[3] - 欲传送的字节数 count
+// 返回：实际传送的字节数，出错则返回出错码
+int sys_sendfile(unsigned long *args)
+{
+	struct file *in, *out;
+	struct m_inode *inode;
+	struct buffer_head *bh;
+	unsigned int out_fd, in_fd;
+	unsigned long old_fs;
+	off_t *offset, pos;
+	int count, chars, nr, dev, i, sent = 0;
+	char *p;
+
+	// 从用户空间取参数
+	out_fd = get_fs_long(args);
+	in_fd = get_fs_long(args + 1);
+	offset = (off_t *)get_fs_long(args + 2);
+	count = get_fs_long(args + 3);
+
+	if (out_fd >= NR_OPEN || in_fd >= NR_OPEN || count < 0 ||
+		!(out = current->filp[out_fd]) || !(in = current->filp[in_fd]))
+		return -EINVAL;
+	if (!count)
+		return 0;
+
+	// 源文件只能是常规文件或块设备，它们的数据才在高速缓冲中
+	inode = in->f_inode;
+	if (!S_ISREG(inode->i_mode) && !S_ISBLK(inode->i_mode))
+		return -EINVAL;
+
+	// 取读取位置。对于常规文件，传送的字节数不能超过文件末尾
+	if (offset)
+	{
+		verify_area(offset, 4);
+		pos = get_fs_long((unsigned long *)offset);
+	}
+	else
+		pos = in->f_pos;
+	if (pos < 0)
+		return -EINVAL;
+	if (S_ISREG(inode->i_mode))
+	{
+		if (pos >= inode->i_size)
+			return 0;
+		if (count > inode->i_size - pos)
+			count = inode->i_size - pos;
+	}
+
+	old_fs = get_fs();
+	while (count > 0)
+	{
+		// 每次传送一个数据块中的数据
+		chars = BLOCK_SIZE - (pos % BLOCK_SIZE);
+		if (chars > count)
+			chars = count;
+
+		// 取数据所在的高速缓冲块。块设备与 block_read() 一样进行预读，
+		// 常规文件中逻辑块号为 0 说明是空洞，数据都是 0
+		bh = NULL;
+		if (S_ISBLK(inode->i_mode))
+		{
+			nr = pos / BLOCK_SIZE;
+			dev = inode->i_zone[0];
+			bh = breada(dev, nr, nr + 1, nr + 2, -1);
+		}
+		else if ((nr = bmap(inode, pos / BLOCK_SIZE)))
+			bh = bread(inode->i_dev, nr);
+		if (!bh && (nr || S_ISBLK(inode->i_mode)))
+		{
+			if (!sent)
+				sent = -EIO;
+			break;
+		}
+		p = (bh ? bh->b_data : zero_block) + (pos % BLOCK_SIZE);
+
+		// 让 fs 指向内核数据段，写函数用 get_fs_byte() 取到的就是高速缓冲中的数据
+		// fs 不是用户数据段，写到以 O_DIRECT 方式打开的文件时 write_file() 也经过高速缓冲
+		set_fs(get_ds());
+		i = write_file(out, p, chars);
+		set_fs(old_fs);
+		brelse(bh);
+
+		// 写出错则返回已传送的字节数，一个字节都没有传送则返回出错码
+		if (i <= 0)
+		{
+			if (!sent)
+				sent = i;
+			break;
+		}
+		sent += i;
+		pos += i;
+		count -= i;
+
+		// 只写出了一部分（例如管道读端已关闭），不再继续
+		if (i < chars)
+			break;
+	}
+
+	// 更新读取位置
+	if (sent > 0)
+	{
+		if (offset)
+			put_fs_long(pos, (unsigned long *)offset);
+		else
+			in->f_pos = pos;
+	}
+	return sent;
+}
+
+// readv() 和 writev() 的公共部分，rw 是 READ 或 WRITE
+// 先把用户的 iovec 数组一次复制到内核中并验证全部缓冲区，
+// 然后依次对每一段调用 read_file() 或 write_file()
+// 某一段没有读写完（例如管道或终端中的数据不够）就不再继续
+// 返回：读写的总字节数，一个字节也没有读写则返回出错码
+static int rw_vector(int rw, unsigned int fd, struct iovec *iov, int iovcnt)
+{
+	struct iovec vec[UIO_MAXIOV];
+	struct file *file;
+	int i, n, total = 0;
+
+	if (fd >= NR_OPEN || !(file = current->filp[fd]))
+		return -EBADF;
+	if (iovcnt < 0 || iovcnt > UIO_MAXIOV)
+		return -EINVAL;
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		vec[i].iov_base = (void *)get_fs_long((unsigned long *)&iov[i].iov_base);
+		vec[i].iov_len = get_fs_long((unsigned long *)&iov[i].iov_len);
+		if ((int)vec[i].iov_len < 0)
+			return -EINVAL;
+		if (rw == READ && vec[i].iov_len)
+			verify_area(vec[i].iov_base, vec[i].iov_len);
+	}
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		if (!vec[i].iov_len)
+			continue;
+		if (rw == READ)
+			n = read_file(file, vec[i].iov_base, vec[i].iov_len);
+		else
+			n = write_file(file, vec[i].iov_base, vec[i].iov_len);
+		if (n <= 0)
+			return total ? total : n;
+		total += n;
+		if (n < vec[i].iov_len)
+			break;
+	}
+	return total;
+}
+
+// 系统调用 readv()，把文件中的数据依次读入 iovcnt 个缓冲区中
+int sys_readv(unsigned int fd, struct iovec *iov, int iovcnt)
+{
+	return rw_vector(READ, fd, iov, iovcnt);
+}
+
+// 系统调用 writev()，把 iovcnt 个缓冲区中的数据依次写入文件
+int sys_writev(unsigned int fd, struct iovec *iov, int iovcnt)
+{
+	return rw_vector(WRITE, fd, iov, iovcnt);
+}
+
+// pread() 和 pwrite() 的公共部分，在指定位置读写文件，不使用也不改变文件的读写指针
+// 读写是在文件结构的一个副本上进行的，副本的读写指针设置为指定位置，
+// 因此 file_read()/file_write()/block_read()/block_write() 都不需要修改
+// 参数通过用户空间中的参数块 args 传递：
+// args[0] - fd；args[1] - buf；args[2] - count；args[3] - offset
+static int rw_at(int rw, unsigned long *args)
+{
+	struct file *file, tmp;
+	unsigned int fd;
+	char *buf;
+	int count;
+
+	fd = get_fs_long(args);
+	buf = (char *)get_fs_long(args + 1);
+	count = get_fs_long(args + 2);
+	if (fd >= NR_OPEN || count < 0 || !(file = current->filp[fd]))
+		return -EINVAL;
+
+	// 管道和套接字不能定位
+	if (file->f_inode->i_pipe || file->f_inode->i_sock)
+		return -ESPIPE;
+	tmp = *file;
+	if ((tmp.f_pos = get_fs_long(args + 3)) < 0)
+		return -EINVAL;
+	if (!count)
+		return 0;
+
+	if (rw == READ)
+	{
+		verify_area(buf, count);
+		return read_file(&tmp, buf, count);
+	}
+	return write_file(&tmp, buf, count);
+}
+
+// 系统调用 pread()，从文件的指定位置读数据
+int sys_pread(unsigned long *args)
+{
+	return rw_at(READ, args);
+}
+
+// 系统调用 pwrite()，向文件的指定位置写数据
+int sys_pwrite(unsigned long *args)
+{
+	return rw_at(WRITE, args);
+}
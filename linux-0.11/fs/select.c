@@ -0,0 +1,311 @@
+/*
+ *  linux/fs/select.c
+ */
+
+// select() / poll() 系统调用，一个进程可以同时等待多个终端和管道
+// 文件未就绪时，进程在该文件的等待队列（终端的 secondary/write_q.proc_list、管道的 i_wait）上登记，
+// 然后可中断地睡眠，任何一个队列被 wake_up() 时进程都会被唤醒，再重新检查各个文件
+// 内核的等待队列是由 sleep_on() 的局部变量串起来的，一个进程不能同时在多个队列中睡眠，
+// 也不能从队列中间退出，因此登记项单独放在 select_table 中，由 wake_up() 按队列地址查找
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/select.h>
+#include <sys/poll.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/tty.h>
+#include <asm/segment.h>
+#include <asm/system.h>
+
+// 系统中同时可以登记的等待项数
+#define NR_SELECT 64
+
+// 等待项：进程 task 在等待队列 wait_address 上等待，task 为空表示该项空闲
+static struct select_entry
+{
+	struct task_struct *task;
+	struct task_struct **wait_address;
+} select_table[NR_SELECT];
+
+// 已使用的等待项数，为 0 时 wake_up() 不必查找等待项表
+int select_nr = 0;
+
+// 唤醒在等待队列 p 上登记的、正在 select()/poll() 中睡眠的进程，由 wake_up() 调用，可能在中断中执行
+void select_wake(struct task_struct **p)
+{
+	struct select_entry *e;
+
+	if (!p)
+		return;
+	for (e = select_table; e < select_table + NR_SELECT; e++)
+		if (e->wait_address == p && e->task->state == TASK_INTERRUPTIBLE)
+			e->task->state = TASK_RUNNING;
+}
+
+// 在等待队列 p 上为当前进程登记一项，已经登记过则不再重复登记
+// 等待项表已满时不登记，而是让进程最多睡眠 1 个滴答后重新检查
+static void add_wait(struct task_struct **p)
+{
+	struct select_entry *e, *free = NULL;
+
+	for (e = select_table; e < select_table + NR_SELECT; e++)
+	{
+		if (e->task == current && e->wait_address == p)
+			return;
+		if (!e->task && !free)
+			free = e;
+	}
+	if (!free)
+	{
+		if (!current->timeout || current->timeout > jiffies + 1)
+			current->timeout = jiffies + 1;
+		return;
+	}
+	cli();
+	free->task = current;
+	free->wait_address = p;
+	select_nr++;
+	sti();
+}
+
+// 撤销当前进程登记的所有等待项
+static void free_wait(void)
+{
+	struct select_entry *e;
+
+	cli();
+	for (e = select_table; e < select_table + NR_SELECT; e++)
+		if (e->task == current)
+		{
+			e->wait_address = NULL;
+			e->task = NULL;
+			select_nr--;
+		}
+	sti();
+}
+
+// 取 i 节点对应的终端，不是终端则返回 NULL
+static struct tty_struct *get_tty(struct m_inode *inode)
+{
+	int dev;
+
+	if (!S_ISCHR(inode->i_mode))
+		return NULL;
+	dev = inode->i_zone[0];
+	if (MAJOR(dev) == 5)
+		dev = current->tty;
+	else if (MAJOR(dev) == 4)
+		dev = MINOR(dev);
+	else
+		return NULL;
+	if (dev < 0 || dev >= NR_TTY)
+		return NULL;
+	return tty_table + dev;
+}
+
+// 取文件 file 当前的就绪状态，是 POLLIN、POLLOUT、POLLHUP 的组合
+// 若 wait 非 0，则对 events 中关心而尚未就绪的方向，在相应的等待队列上登记当前进程
+static int file_poll(struct file *file, int events, int wait)
+{
+	struct m_inode *inode = file->f_inode;
+	struct tty_struct *tty;
+	struct task_struct **rq, **wq;
+	int mask = 0;
+
+	if (inode->i_pipe)
+	{
+		// 管道的另一端已经关闭时，读返回 0，写产生 SIGPIPE，都不会阻塞
+		if (inode->i_count != 2)
+			return POLLIN | POLLOUT | POLLHUP;
+		if (!PIPE_EMPTY(*inode))
+			mask |= POLLIN;
+		if (!PIPE_FULL(*inode))
+			mask |= POLLOUT;
+		rq = wq = &inode->i_wait;
+	}
+	else if (inode->i_sock)
+		mask = sock_poll(inode, &rq, &wq);
+	else if (S_ISCHR(inode->i_mode) && MAJOR(inode->i_zone[0]) == 4 &&
+			 IS_PTY_MASTER(MINOR(inode->i_zone[0])))
+		mask = pty_poll(MINOR(inode->i_zone[0]) - PTY_MASTER, &rq, &wq);
+	else if ((tty = get_tty(inode)))
+	{
+		// 与 tty_read() 的判断相同：规范模式下要等到有完整的一行（或辅助队列快满）才可读
+		// 原始输入模式下字符留在读队列中
+		if (!EMPTY(tty->secondary) &&
+			!((tty->termios.c_lflag & ICANON) && !tty->secondary.data && LEFT(tty->secondary) > 20))
+			mask |= POLLIN;
+		else if (RAW_INPUT(tty) && !EMPTY(tty->read_q))
+			mask |= POLLIN;
+		if (!FULL(tty->write_q))
+			mask |= POLLOUT;
+		rq = &tty->secondary.proc_list;
+		wq = &tty->write_q.proc_list;
+	}
+	else
+		// 常规文件、目录和块设备的读写总是立即完成
+		return POLLIN | POLLOUT;
+
+	if (wait)
+	{
+		if ((events & POLLIN) && !(mask & POLLIN))
+			add_wait(rq);
+		if ((events & POLLOUT) && !(mask & POLLOUT))
+			add_wait(wq);
+	}
+	return mask;
+}
+
+// select() 和 poll() 的公共部分：检查 nfds 个文件（已复制到内核中），直到至少一个就绪
+// ticks 是最长等待的滴答数，小于 0 表示一直等待，为 0 表示只检查一次而不等待
+// 返回：revents 不为 0 的项数；没有文件就绪而收到信号时返回 -EINTR
+static int do_poll(struct pollfd *fds, int nfds, long ticks)
+{
+	struct pollfd *p;
+	struct file *file;
+	long deadline = (ticks > 0) ? jiffies + ticks : 0;
+	int count, wait = (ticks != 0);
+
+	for (;;)
+	{
+		// 先置为可中断睡眠状态再检查，这样检查之后到 schedule() 之前的唤醒不会丢失
+		current->timeout = deadline;
+		current->state = TASK_INTERRUPTIBLE;
+		count = 0;
+		for (p = fds; p < fds + nfds; p++)
+		{
+			if (p->fd < 0)
+				p->revents = 0;
+			else if (p->fd >= NR_OPEN || !(file = current->filp[p->fd]))
+				p->revents = POLLNVAL;
+			else
+				p->revents = file_poll(file, p->events, wait) &
+							 (p->events | POLLERR | POLLHUP | POLLNVAL);
+			if (p->revents)
+				count++;
+		}
+		if (count || !wait || (deadline && deadline <= jiffies) ||
+			(current->signal & ~current->blocked))
+			break;
+		schedule();
+	}
+	current->state = TASK_RUNNING;
+	current->timeout = 0;
+	free_wait();
+	if (!count && wait && (current->signal & ~current->blocked))
+		return -EINTR;
+	return count;
+}
+
+// 系统调用 select()，等待 readfds/writefds 中的文件可读/可写
+// 由于参数多于 3 个，用户程序通过 select_arg_struct 结构指针 arg 传递参数
+// exceptfds 中的文件不会有异常情况，只检查文件描述符是否有效
+// 返回：就绪的文件描述符数，各描述符集中只保留就绪的描述符；超时返回 0，出错返回出错码
+int sys_select(struct select_arg_struct *arg)
+{
+	struct select_arg_struct a;
+	struct pollfd fds[NR_OPEN];
+	fd_set in = 0, out = 0, ex = 0, mask;
+	long ticks = -1, usec;
+	int i, nfds = 0, count;
+
+	// 从用户空间复制参数
+	for (i = 0; i < sizeof(a) / 4; i++)
+		((unsigned long *)&a)[i] = get_fs_long(((unsigned long *)arg) + i);
+	mask = (a.n >= NR_OPEN) ? (1UL << NR_OPEN) - 1 : (1UL << a.n) - 1;
+	if (a.readfds)
+		in = get_fs_long(a.readfds) & mask;
+	if (a.writefds)
+		out = get_fs_long(a.writefds) & mask;
+	if (a.exceptfds)
+		ex = get_fs_long(a.exceptfds) & mask;
+
+	// 超时时间换算成滴答数，不足 1 个滴答的按 1 个滴答计算
+	if (a.timeout)
+	{
+		ticks = get_fs_long((unsigned long *)&a.timeout->tv_sec);
+		usec = get_fs_long((unsigned long *)&a.timeout->tv_usec);
+		if (ticks < 0 || usec < 0)
+			return -EINVAL;
+		ticks = ticks * HZ + (usec + 1000000 / HZ - 1) / (1000000 / HZ);
+	}
+
+	for (i = 0; i < NR_OPEN; i++)
+	{
+		if (!(((in | out | ex) >> i) & 1))
+			continue;
+		if (!current->filp[i])
+			return -EBADF;
+		if (((in | out) >> i) & 1)
+		{
+			fds[nfds].fd = i;
+			fds[nfds++].events = (((in >> i) & 1) ? POLLIN : 0) | (((out >> i) & 1) ? POLLOUT : 0);
+		}
+	}
+	if ((count = do_poll(fds, nfds, ticks)) < 0)
+		return count;
+
+	// 把结果转换回描述符集，对端已关闭的管道既可读也可写
+	in = out = 0;
+	count = 0;
+	for (i = 0; i < nfds; i++)
+	{
+		if ((fds[i].events & POLLIN) && (fds[i].revents & (POLLIN | POLLHUP)))
+		{
+			in |= 1UL << fds[i].fd;
+			count++;
+		}
+		if ((fds[i].events & POLLOUT) && (fds[i].revents & (POLLOUT | POLLHUP)))
+		{
+			out |= 1UL << fds[i].fd;
+			count++;
+		}
+	}
+	if (a.readfds)
+	{
+		verify_area(a.readfds, sizeof(fd_set));
+		put_fs_long(in, a.readfds);
+	}
+	if (a.writefds)
+	{
+		verify_area(a.writefds, sizeof(fd_set));
+		put_fs_long(out, a.writefds);
+	}
+	if (a.exceptfds)
+	{
+		verify_area(a.exceptfds, sizeof(fd_set));
+		put_fs_long(0, a.exceptfds);
+	}
+	return count;
+}
+
+// 系统调用 poll()，等待 fds 中 nfds 个文件发生关心的事件
+// timeout 是最长等待的毫秒数，小于 0 表示一直等待
+// 返回：revents 不为 0 的项数；超时返回 0，出错返回出错码
+int sys_poll(struct pollfd *fds, unsigned long nfds, int timeout)
+{
+	struct pollfd tmp[NR_POLL];
+	long ticks;
+	int i, count;
+
+	if (nfds > NR_POLL)
+		return -EINVAL;
+	for (i = 0; i < nfds; i++)
+	{
+		tmp[i].fd = get_fs_long((unsigned long *)&fds[i].fd);
+		tmp[i].events = get_fs_word((unsigned short *)&fds[i].events);
+	}
+	if (timeout < 0)
+		ticks = -1;
+	else
+		ticks = ((long)timeout * HZ + 999) / 1000;
+
+	if ((count = do_poll(tmp, nfds, ticks)) < 0)
+		return count;
+	verify_area(fds, nfds * sizeof(struct pollfd));
+	for (i = 0; i < nfds; i++)
+		put_fs_word(tmp[i].revents, &fds[i].revents);
+	return count;
+}
@@ -0,0 +1,380 @@
+/*
+ *  linux/fs/socket.c
+ */
+
+// UNIX 域字节流套接字 socket() / bind() / listen() / accept() / connect()
+// 套接字的名字是文件系统中类型为 S_IFSOCK 的节点，由 bind() 像 mknod() 那样建立，
+// 与之无关的进程可以通过路径名找到监听的套接字并与之连接
+// 一个连接由两个管道 i 节点组成，每个方向一个，每端从自己的接收管道读，向对方的接收管道写，
+// 因此数据传送、等待和唤醒、对端关闭后的文件结束与 SIGPIPE 都直接使用管道的代码
+// 每个管道 i 节点的引用次数为 2（读端一次，写端一次），与普通管道相同
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/poll.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <asm/segment.h>
+
+// 管道读写函数，在 fs/pipe.c 中
+extern int read_pipe(struct m_inode *inode, char *buf, int count);
+extern int write_pipe(struct m_inode *inode, char *buf, int count);
+
+// 系统中同时存在的套接字数
+#define NR_SOCKET 16
+// 每个方向接收缓冲区的大小
+#define SOCK_BUF_SIZE (4 * PAGE_SIZE)
+
+// 套接字的状态
+#define SS_UNCONNECTED 0 // 未连接
+#define SS_LISTENING 1	 // 正在监听，等待连接
+#define SS_CONNECTED 2	 // 已连接
+
+// 套接字
+static struct unix_sock
+{
+	struct m_inode *inode; // 套接字 i 节点，为空表示该项空闲
+	int state;			   // 状态 SS_*
+	struct m_inode *name;  // 绑定的名字节点
+	struct m_inode *rx;	   // 接收管道，从中读
+	struct m_inode *tx;	   // 发送管道（对方的接收管道），向其中写
+	struct unix_sock *queue; // 监听套接字上已连接但尚未被 accept() 接受的套接字
+	struct unix_sock *next;	 // 在监听套接字的 queue 中链接
+	int qlen, backlog;		 // queue 中的套接字数及其上限
+} unix_socks[NR_SOCKET];
+
+// 取文件句柄 fd 对应的套接字
+// 返回：套接字指针，fd 无效或不是套接字则返回 NULL
+static struct unix_sock *get_sock(unsigned int fd)
+{
+	struct file *file;
+
+	if (fd >= NR_OPEN || !(file = current->filp[fd]) || !file->f_inode->i_sock)
+		return NULL;
+	return unix_socks + file->f_inode->i_sock - 1;
+}
+
+// 取 i 节点对应的套接字
+#define INODE_SOCK(inode) (unix_socks + (inode)->i_sock - 1)
+
+// 建立一个未连接的套接字及其 i 节点，i 节点的引用次数为 1
+// 返回：套接字指针，套接字表已满则返回 NULL
+static struct unix_sock *sock_alloc(void)
+{
+	struct unix_sock *s;
+	struct m_inode *inode;
+
+	// get_empty_inode() 可能睡眠，因此先取 i 节点，再找空闲的套接字表项
+	if (!(inode = get_empty_inode()))
+		return NULL;
+	for (s = unix_socks; s < unix_socks + NR_SOCKET; s++)
+		if (!s->inode)
+			break;
+	if (s >= unix_socks + NR_SOCKET)
+	{
+		inode->i_count = 0;
+		return NULL;
+	}
+	inode->i_mode = S_IFSOCK | 0777;
+	inode->i_uid = current->euid;
+	inode->i_gid = current->egid;
+	inode->i_atime = inode->i_mtime = inode->i_ctime = CURRENT_TIME;
+	inode->i_sock = s - unix_socks + 1;
+	s->inode = inode;
+	s->state = SS_UNCONNECTED;
+	s->name = s->rx = s->tx = NULL;
+	s->queue = s->next = NULL;
+	s->qlen = s->backlog = 0;
+	return s;
+}
+
+// 为套接字 i 节点取得一个文件结构和文件句柄，以读写方式打开，不会睡眠
+// 返回：文件句柄，出错则返回出错码
+static int sock_fd(struct m_inode *inode)
+{
+	struct file *f;
+	int fd, i;
+
+	for (fd = 0; fd < NR_OPEN; fd++)
+		if (!current->filp[fd])
+			break;
+	if (fd >= NR_OPEN)
+		return -EMFILE;
+	f = file_table;
+	for (i = 0; i < NR_FILE; i++, f++)
+		if (!f->f_count)
+			break;
+	if (i >= NR_FILE)
+		return -ENFILE;
+	current->close_on_exec &= ~(1 << fd);
+	(current->filp[fd] = f)->f_count = 1;
+	f->f_mode = 3;
+	f->f_flags = O_RDWR;
+	f->f_inode = inode;
+	f->f_pos = 0;
+	return fd;
+}
+
+// 检查用户空间中的 UNIX 域地址 addr
+// 返回：其中路径名在用户空间中的地址，地址无效则返回 NULL
+static char *sock_path(struct sockaddr *addr, int addrlen)
+{
+	if (!addr || addrlen <= sizeof(unsigned short) || addrlen > sizeof(struct sockaddr_un))
+		return NULL;
+	if (get_fs_word(&addr->sa_family) != AF_UNIX)
+		return NULL;
+	return ((struct sockaddr_un *)addr)->sun_path;
+}
+
+// 系统调用 socket()，建立一个 UNIX 域字节流套接字
+// 返回：文件句柄，出错则返回出错码
+int sys_socket(int domain, int type, int protocol)
+{
+	struct unix_sock *s;
+	int fd;
+
+	if (domain != AF_UNIX)
+		return -EAFNOSUPPORT;
+	if (type != SOCK_STREAM || protocol)
+		return -EINVAL;
+	if (!(s = sock_alloc()))
+		return -ENFILE;
+	if ((fd = sock_fd(s->inode)) < 0)
+		iput(s->inode);
+	return fd;
+}
+
+// 系统调用 bind()，在文件系统中建立名字节点 addr 并绑定到套接字 fd 上
+// 名字节点在套接字关闭后仍然存在，需要用 unlink() 删除
+int sys_bind(unsigned int fd, struct sockaddr *addr, int addrlen)
+{
+	struct unix_sock *s;
+	char *path;
+	int error;
+
+	if (!(s = get_sock(fd)))
+		return -ENOTSOCK;
+	if (s->name || s->state != SS_UNCONNECTED)
+		return -EINVAL;
+	if (!(path = sock_path(addr, addrlen)))
+		return -EINVAL;
+	if ((error = do_mknod(path, S_IFSOCK | (0777 & ~current->umask), 0)))
+		return (error == -EEXIST) ? -EADDRINUSE : error;
+	if (!(s->name = namei(path)))
+		return -ENOENT;
+	return 0;
+}
+
+// 系统调用 listen()，让已绑定名字的套接字 fd 开始接受连接
+// backlog 是等待接受的连接数上限，最大为 SOMAXCONN
+int sys_listen(unsigned int fd, int backlog)
+{
+	struct unix_sock *s;
+
+	if (!(s = get_sock(fd)))
+		return -ENOTSOCK;
+	if (s->state == SS_CONNECTED)
+		return -EISCONN;
+	if (!s->name)
+		return -EINVAL;
+	if (backlog < 1)
+		backlog = 1;
+	if (backlog > SOMAXCONN)
+		backlog = SOMAXCONN;
+	s->backlog = backlog;
+	s->state = SS_LISTENING;
+	return 0;
+}
+
+// 系统调用 connect()，把套接字 fd 连接到名字为 addr 的监听套接字上
+// 连接立即建立：服务端的套接字此时就建好并放入监听套接字的等待队列，
+// 因此在对方 accept() 之前就可以开始写数据。等待队列已满时拒绝连接
+int sys_connect(unsigned int fd, struct sockaddr *addr, int addrlen)
+{
+	struct unix_sock *s, *l, *new, **p;
+	struct m_inode *inode;
+	char *path;
+	int error;
+
+	if (!(s = get_sock(fd)))
+		return -ENOTSOCK;
+	if (s->state != SS_UNCONNECTED)
+		return -EISCONN;
+	if (!(path = sock_path(addr, addrlen)))
+		return -EINVAL;
+
+	// 先做所有可能睡眠的事情：查找名字节点，建立服务端套接字和两个方向的管道
+	if (!(inode = namei(path)))
+		return -ENOENT;
+	if (!(new = sock_alloc()))
+	{
+		iput(inode);
+		return -ENFILE;
+	}
+	new->rx = get_pipe_inode();
+	s->rx = get_pipe_inode();
+	if (!new->rx || !s->rx)
+	{
+		// 管道的两次引用都要放回
+		if (new->rx)
+		{
+			iput(new->rx);
+			iput(new->rx);
+		}
+		if (s->rx)
+		{
+			iput(s->rx);
+			iput(s->rx);
+		}
+		new->rx = s->rx = NULL;
+		iput(new->inode);
+		iput(inode);
+		return -ENOMEM;
+	}
+	pipe_resize(new->rx, SOCK_BUF_SIZE);
+	pipe_resize(s->rx, SOCK_BUF_SIZE);
+	new->tx = s->rx;
+	s->tx = new->rx;
+	new->state = SS_CONNECTED;
+
+	// 查找在该名字上监听的套接字，到把新套接字放入其等待队列为止不会睡眠
+	for (l = unix_socks; l < unix_socks + NR_SOCKET; l++)
+		if (l->inode && l->state == SS_LISTENING && l->name == inode)
+			break;
+	if (l >= unix_socks + NR_SOCKET || l->qlen >= l->backlog)
+	{
+		// 释放新套接字时会放回两个管道各自的一次引用，这里放回本端持有的引用
+		error = S_ISSOCK(inode->i_mode) ? -ECONNREFUSED : -ENOTSOCK;
+		iput(s->rx);
+		iput(s->tx);
+		s->rx = s->tx = NULL;
+		iput(new->inode);
+		iput(inode);
+		return error;
+	}
+	for (p = &l->queue; *p; p = &(*p)->next)
+		;
+	*p = new;
+	l->qlen++;
+	s->state = SS_CONNECTED;
+	wake_up(&l->inode->i_wait);
+	iput(inode);
+	return 0;
+}
+
+// 系统调用 accept()，从监听套接字 fd 上接受一个连接，没有连接时睡眠等待
+// 对方的套接字没有名字，addr 中只返回地址族
+// 返回：新连接的文件句柄，出错则返回出错码
+int sys_accept(unsigned int fd, struct sockaddr *addr, int *addrlen)
+{
+	struct unix_sock *s, *new;
+	int newfd;
+
+	if (!(s = get_sock(fd)))
+		return -ENOTSOCK;
+	if (s->state != SS_LISTENING)
+		return -EINVAL;
+	while (!s->queue)
+	{
+		if (current->signal & ~current->blocked)
+			return -EINTR;
+		interruptible_sleep_on(&s->inode->i_wait);
+	}
+
+	// 等待队列中套接字的 i 节点引用转给新的文件结构
+	new = s->queue;
+	if ((newfd = sock_fd(new->inode)) < 0)
+		return newfd;
+	s->queue = new->next;
+	s->qlen--;
+	new->next = NULL;
+	if (addr)
+	{
+		verify_area(addr, sizeof(unsigned short));
+		put_fs_word(AF_UNIX, &addr->sa_family);
+	}
+	if (addrlen)
+	{
+		verify_area(addrlen, sizeof(int));
+		put_fs_long(sizeof(unsigned short), (unsigned long *)addrlen);
+	}
+	return newfd;
+}
+
+// 读套接字，由 sys_read() 等调用
+int sock_read(struct m_inode *inode, char *buf, int count)
+{
+	struct unix_sock *s = INODE_SOCK(inode);
+
+	if (s->state != SS_CONNECTED)
+		return -ENOTCONN;
+	return read_pipe(s->rx, buf, count);
+}
+
+// 写套接字，由 sys_write() 等调用
+int sock_write(struct m_inode *inode, char *buf, int count)
+{
+	struct unix_sock *s = INODE_SOCK(inode);
+
+	if (s->state != SS_CONNECTED)
+		return -ENOTCONN;
+	return write_pipe(s->tx, buf, count);
+}
+
+// 取套接字的就绪状态（POLL* 的组合）以及读、写方向的等待队列，由 select()/poll() 调用
+int sock_poll(struct m_inode *inode, struct task_struct ***rq, struct task_struct ***wq)
+{
+	struct unix_sock *s = INODE_SOCK(inode);
+	int mask = 0;
+
+	*rq = *wq = &inode->i_wait;
+	switch (s->state)
+	{
+	case SS_LISTENING:
+		// 有等待接受的连接时可读
+		return s->queue ? POLLIN : 0;
+	case SS_CONNECTED:
+		// 对方关闭后，读返回 0，写产生 SIGPIPE，都不会阻塞
+		if (s->rx->i_count != 2)
+			return POLLIN | POLLOUT | POLLHUP;
+		if (!PIPE_EMPTY(*s->rx))
+			mask |= POLLIN;
+		if (!PIPE_FULL(*s->tx))
+			mask |= POLLOUT;
+		*rq = &s->rx->i_wait;
+		*wq = &s->tx->i_wait;
+		return mask;
+	}
+	return POLLOUT | POLLHUP;
+}
+
+// 释放套接字，在其 i 节点的最后一次引用被放回时由 iput() 调用
+// 放回两个管道的引用后，对方读到文件结束，写时收到 SIGPIPE
+// 监听套接字上尚未被接受的连接都被关闭
+void sock_release(struct m_inode *inode)
+{
+	struct unix_sock *s = INODE_SOCK(inode), *q;
+
+	// 下面的 iput() 可能睡眠，因此先让其它进程不能再找到该套接字
+	inode->i_sock = 0;
+	s->state = SS_UNCONNECTED;
+	while ((q = s->queue))
+	{
+		s->queue = q->next;
+		iput(q->inode);
+	}
+	s->qlen = 0;
+	if (s->rx)
+		iput(s->rx);
+	if (s->tx)
+		iput(s->tx);
+	if (s->name)
+		iput(s->name);
+	s->rx = s->tx = s->name = NULL;
+	s->inode = NULL;
+}
@@ -207,7 +207,14 @@ static struct super_block *read_super(int dev)
 
 	// 然后锁定该超级块，并从设备上读取超级块信息到 bh 指向的缓冲区中
 	// 如果读超级块操作失败，则释放上面选定的超级块数组中的项，并解锁该项，返回空指针退出
+	// proc 伪文件系统不在设备上，超级块由 proc_read_super() 填写
 	lock_super(s);
+	if (dev == PROC_DEV)
+	{
+		proc_read_super(s);
+		free_super(s);
+		return s;
+	}
 	if (!(bh = bread(dev, 1)))
 	{
 		s->s_dev = 0;
@@ -66,6 +66,40 @@ static inline void put_fs_long(unsigned long val, unsigned long *addr)
 	__asm__("movl %0,%%fs:%1" ::"r"(val), "m"(*addr));
 }
 
+// 从 fs 段中的 from 处复制 n 字节到内核 to 处
+// 先按长字复制，再复制剩余的不足 4 个字节，源操作数使用 fs 段前缀
+static inline void memcpy_fromfs(void *to, const void *from, unsigned long n)
+{
+	int d0, d1, d2;
+
+	__asm__ __volatile__("cld\n\t"
+						 "rep; fs; movsl\n\t"
+						 "movl %6,%%ecx\n\t"
+						 "rep; fs; movsb"
+						 : "=&c"(d0), "=&D"(d1), "=&S"(d2)
+						 : "0"(n >> 2), "1"(to), "2"(from), "r"(n & 3)
+						 : "memory");
+}
+
+// 从内核 from 处复制 n 字节到 fs 段中的 to 处
+// 串操作的目的段只能是 es，因此暂时把 fs 的值放到 es 中
+static inline void memcpy_tofs(void *to, const void *from, unsigned long n)
+{
+	int d0, d1, d2;
+
+	__asm__ __volatile__("push %%es\n\t"
+						 "push %%fs\n\t"
+						 "pop %%es\n\t"
+						 "cld\n\t"
+						 "rep; movsl\n\t"
+						 "movl %6,%%ecx\n\t"
+						 "rep; movsb\n\t"
+						 "pop %%es"
+						 : "=&c"(d0), "=&D"(d1), "=&S"(d2)
+						 : "0"(n >> 2), "1"(to), "2"(from), "r"(n & 3)
+						 : "memory");
+}
+
 // 比我更懂 GNU 汇编的人应该仔细检查下面的代码
 // 这些代码能使用，但我不知道是否含有一些小错误
 // --- TYT，1991 年 11 月 24 日
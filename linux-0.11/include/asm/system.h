@@ -26,11 +26,34 @@
 			"movw %%ax,%%gs" ::        \
 				: "ax")
 
+// 不经统计的开中断、关中断，供 kernel/irqlat.c 自己使用
+#define __sti() __asm__("sti" ::)
+#define __cli() __asm__("cli" ::)
+
+// 保存标志寄存器到 x 中，之后可以关中断，再用 restore_flags(x) 恢复到原来的中断状态
+// 用于可能在关中断状态下调用的代码（例如中断处理程序也会调用的函数），不能直接 sti()
+#define save_flags(x) __asm__ __volatile__("pushfl\n\tpopl %0" \
+										   : "=r"(x))
+#define __restore_flags(x) __asm__ __volatile__("pushl %0\n\tpopfl" ::"r"(x))
+
+#ifdef IRQ_LATENCY
+// 统计关中断的时间，见 kernel/irqlat.c
+extern void irqlat_sti(void);
+extern void irqlat_cli(void);
+extern void irqlat_restore(unsigned long flags);
+extern void irqlat_switch(void);
+#define sti() irqlat_sti()
+#define cli() irqlat_cli()
+#define restore_flags(x) irqlat_restore(x)
+#else
 // 开中断 set interrupt
-#define sti() __asm__("sti" ::)
+#define sti() __sti()
 
 // 关中断 clear interrupt
-#define cli() __asm__("cli" ::)
+#define cli() __cli()
+
+#define restore_flags(x) __restore_flags(x)
+#endif
 
 // 空操作 no operation
 #define nop() __asm__("nop" ::)
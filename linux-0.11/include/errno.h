@@ -56,5 +56,11 @@ extern int errno;
 #define ENOLCK 37       // 没有锁定可用
 #define ENOSYS 38       // 功能还没有实现
 #define ENOTEMPTY 39    // 目录不空
+#define ENOTSOCK 40     // 不是套接字
+#define EAFNOSUPPORT 41 // 不支持的地址族
+#define EADDRINUSE 42   // 地址已被使用
+#define EISCONN 43      // 套接字已经连接
+#define ENOTCONN 44     // 套接字没有连接
+#define ECONNREFUSED 45 // 连接被拒绝
 
 #endif
@@ -20,6 +20,7 @@
 #define O_APPEND 02000	 // 以添加方式打开，文件指针置为文件尾
 #define O_NONBLOCK 04000 // 非阻塞方式打开和操作文件
 #define O_NDELAY O_NONBLOCK
+#define O_DIRECT 010000	 // 直接 I/O，不经过高速缓冲（只用于常规文件和块设备）
 
 // 下面定义了 fcntl 的命令，注意目前锁定命令还没有支持
 // 而其它命令实际上还没有测试过
@@ -34,6 +35,10 @@
 #define F_SETLK 6  // 设置(F_RDLCK 或F_WRLCK)或清除(F_UNLCK)锁定
 #define F_SETLKW 7 // 等待设置或清除锁定
 
+// 设置和读取管道缓冲区的大小（字节数），只能用于管道
+#define F_SETPIPE_SZ 8
+#define F_GETPIPE_SZ 9
+
 /* for F_[GET|SET]FL */
 // 在执行 exec() 簇函数时关闭文件句柄，(执行时关闭 - Close On EXECution)
 #define FD_CLOEXEC 1 // 实际上只要低位为1 即可
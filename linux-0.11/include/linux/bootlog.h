@@ -0,0 +1,34 @@
+#ifndef _BOOTLOG_H
+#define _BOOTLOG_H
+
+// 启动过程的时间记录，由 kernel/bootlog.c 实现，通过 /proc/bootlog 读出
+// 实模式阶段由 boot/bootsect.s 和 boot/setup.s 在 BOOT_LOG_ADDR 处记下 BIOS 时钟滴答数（约 55 毫秒一次）：
+//   +0 引导开始  +4 system 加载完毕  +8 setup 开始  +12 进入保护模式之前  +16 标志 BOOT_LOG_MAGIC
+// 这块内存在 buffer_init() 之后就会被高速缓冲覆盖，main() 一开始就调用 boot_log_init() 把它复制出来
+// 之后各个阶段用 boot_stamp() 记下时间戳计数器（TSC）和滴答数，直到第一次从终端读入（shell 等待命令）为止
+#define BOOT_LOG_ADDR 0x90A00
+#define BOOT_LOG_MAGIC 0x4c42
+#define NR_BOOT_BIOS 4
+
+// 保护模式阶段最多记录的项数
+#define NR_BOOT_STAMP 32
+
+struct boot_stamp
+{
+	const char *name;		// 阶段名，指向常量字符串
+	unsigned long long tsc; // 时间戳计数器的值，CPU 没有 TSC 时为 0
+	unsigned long jiffies;	// 滴答数，sched_init() 之后开中断之前都是 0
+	long pid;				// 当前进程号
+};
+
+extern const char *boot_bios_name[NR_BOOT_BIOS];
+extern long boot_bios_ms[NR_BOOT_BIOS];
+extern struct boot_stamp boot_log[NR_BOOT_STAMP];
+extern int nr_boot_stamps;
+
+extern void boot_log_init(void);
+extern void boot_stamp(const char *name);
+extern void boot_log_done(const char *name);
+extern long boot_ms(int i);
+
+#endif
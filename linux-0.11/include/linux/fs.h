@@ -38,7 +38,7 @@ void buffer_init(long buffer_end);
 #define SUPER_MAGIC 0x137F // 文件系统魔数
 
 #define NR_OPEN 20 // 打开文件数
-#define NR_INODE 32
+#define NR_INODE 64
 #define NR_FILE 64
 #define NR_SUPER 8
 #define NR_HASH 307
@@ -55,14 +55,19 @@ void buffer_init(long buffer_end);
 // 每个逻辑块可存放的目录项数
 #define DIR_ENTRIES_PER_BLOCK ((BLOCK_SIZE) / (sizeof(struct dir_entry)))
 
-// 管道头、管道尾、管道大小、管道空？、管道满？、管道头指针递增
+// 管道缓冲区是由若干页面组成的环，页面数是 2 的幂，最多 PIPE_MAX_PAGES 页，可用 fcntl(F_SETPIPE_SZ) 修改
+// 页面数存放在 i_pipe 中，第 1 页的地址存放在 i_size 中，其余各页的页帧号存放在 i_zone[2..8] 中
+#define PIPE_MAX_PAGES 8
+#define PIPE_PAGES(inode) ((inode).i_pipe)
+#define PIPE_BUF_SIZE(inode) (PIPE_PAGES(inode) * PAGE_SIZE)
+#define PIPE_PAGE(inode, nr) ((nr) ? ((unsigned long)(inode).i_zone[(nr) + 1] << 12) : (inode).i_size)
+
+// 管道头、管道尾、管道大小、管道空？、管道满？
 #define PIPE_HEAD(inode) ((inode).i_zone[0])
 #define PIPE_TAIL(inode) ((inode).i_zone[1])
-#define PIPE_SIZE(inode) ((PIPE_HEAD(inode) - PIPE_TAIL(inode)) & (PAGE_SIZE - 1))
+#define PIPE_SIZE(inode) ((PIPE_HEAD(inode) - PIPE_TAIL(inode)) & (PIPE_BUF_SIZE(inode) - 1))
 #define PIPE_EMPTY(inode) (PIPE_HEAD(inode) == PIPE_TAIL(inode))
-#define PIPE_FULL(inode) (PIPE_SIZE(inode) == (PAGE_SIZE - 1))
-#define INC_PIPE(head) \
-	__asm__("incl %0\n\tandl $4095,%0" ::"m"(head))
+#define PIPE_FULL(inode) (PIPE_SIZE(inode) == (PIPE_BUF_SIZE(inode) - 1))
 
 typedef char buffer_block[BLOCK_SIZE]; // 块缓冲区
 
@@ -77,6 +82,7 @@ struct buffer_head
 	unsigned char b_dirt;			 //修改标志：0 未修改,1 已修改
 	unsigned char b_count;			 // 使用的用户数
 	unsigned char b_lock;			 // 缓冲区是否被锁定
+	unsigned char b_reada;			 // 预读进来而还没有被使用过
 	struct task_struct *b_wait;		 // 指向等待该缓冲区解锁的任务
 	struct buffer_head *b_prev;		 // hash 队列上前一块（这四个指针用于缓冲区的管理）
 	struct buffer_head *b_next;		 // hash 队列上下一块
@@ -115,10 +121,12 @@ struct m_inode
 	unsigned short i_count;		// i 节点被使用的次数，0 表示该i 节点空闲
 	unsigned char i_lock;		// 锁定标志
 	unsigned char i_dirt;		// 已修改(脏)标志
-	unsigned char i_pipe;		// 管道标志
+	unsigned char i_pipe;		// 管道标志，对于管道是缓冲区的页面数
+	unsigned char i_sock;		// 套接字标志，对于套接字是其在套接字表中的索引加 1
 	unsigned char i_mount;		// 安装标志
 	unsigned char i_seek;		// 搜寻标志(lseek 时)
 	unsigned char i_update;		// 更新标志
+	long i_pid;					// proc 中进程目录和文件对应的进程号，见 fs/proc.c
 };
 
 // 文件结构（用于在文件句柄与i 节点之间建立关系）
@@ -229,6 +237,9 @@ extern struct m_inode *namei(const char *pathname);
 extern int open_namei(const char *pathname, int flag, int mode,
 					  struct m_inode **res_inode);
 
+// 创建文件系统节点，sys_mknod() 去掉超级用户检查的部分，绑定套接字名字时也使用
+extern int do_mknod(const char *filename, int mode, int dev);
+
 // 释放一个 i 节点(回写入设备)
 extern void iput(struct m_inode *inode);
 
@@ -240,6 +251,46 @@ extern struct m_inode *get_empty_inode(void);
 
 // 获取（申请一）管道节点。返回为 i 节点指针（如果是 NULL 则失败）
 extern struct m_inode *get_pipe_inode(void);
+// 修改管道缓冲区的大小，释放管道缓冲区
+extern int pipe_resize(struct m_inode *inode, unsigned long size);
+extern void free_pipe(struct m_inode *inode);
+
+// UNIX 域套接字的读、写和释放（在 i 节点的最后一次引用被放回时调用），见 fs/socket.c
+extern int sock_read(struct m_inode *inode, char *buf, int count);
+extern int sock_write(struct m_inode *inode, char *buf, int count);
+extern void sock_release(struct m_inode *inode);
+extern int sock_poll(struct m_inode *inode, struct task_struct ***rq, struct task_struct ***wq);
+
+// 高速缓冲和块设备的统计，累计计数在运行中更新，其余各项在 get_blk_stat() 取统计时计算
+// 通过 /dev/blkstat（主设备号 1，次设备号 8）读出
+#define NR_BLK_STAT 7 // 块设备主设备号数，同 kernel/blk_drv/blk.h 中的 NR_BLK_DEV
+struct blk_stat
+{
+	unsigned long getblk_hit;				 // getblk() 在高速缓冲中找到块的次数
+	unsigned long getblk_miss;				 // getblk() 为块分配新缓冲区的次数
+	unsigned long bread_wait;				 // bread()/breada() 读盘并等待的次数
+	unsigned long reada_issued;				 // breada() 发出的预读块数
+	unsigned long reada_useful;				 // 预读的块在被重用之前又被 getblk() 找到的次数
+	unsigned long buffer_wait;				 // 没有空闲缓冲区而睡眠的次数
+	unsigned long request_wait;				 // 请求项用完而睡眠的次数
+	unsigned long sync;						 // sys_sync() 的次数
+	unsigned long sync_dev;					 // sync_dev() 的次数
+	unsigned long requests[NR_BLK_STAT];	 // 各主设备累计的请求项数
+	unsigned long nr_buffers;				 // 缓冲区总数
+	unsigned long nr_dirty;					 // 已修改的缓冲区数
+	unsigned long nr_locked;				 // 正在读写的（上锁的）缓冲区数
+	unsigned long queue_depth[NR_BLK_STAT]; // 各主设备请求队列中的请求项数
+};
+extern struct blk_stat blk_stat;
+extern void get_blk_stat(struct blk_stat *s);
+extern int blk_queue_depth(int major);
+
+// proc 伪文件系统的设备号（主设备号 0，没有块设备驱动），见 fs/proc.c
+#define PROC_DEV 0x0001
+extern void proc_read_super(struct super_block *s);
+extern void proc_read_inode(struct m_inode *inode);
+extern int proc_lookup(struct m_inode *dir, const char *name, int namelen);
+extern int proc_read(struct m_inode *inode, struct file *filp, char *buf, int count);
 
 // 在哈希表中查找指定的数据块，返回找到块的缓冲头指针
 extern struct buffer_head *get_hash_table(int dev, int block);
@@ -249,6 +300,10 @@ extern struct buffer_head *getblk(int dev, int block);
 
 // 读/写数据块
 extern void ll_rw_block(int rw, struct buffer_head *bh);
+// 不经过高速缓冲，在内存与设备之间直接读写同一页面中的若干数据块
+extern int ll_rw_direct(int rw, int dev, int *b, int nr, char *buffer);
+// 直接 I/O 前使高速缓冲中对应的块与设备保持一致
+extern void sync_direct_block(int rw, int dev, int block);
 
 // 释放指定缓冲块
 extern void brelse(struct buffer_head *buf);
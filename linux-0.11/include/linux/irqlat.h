@@ -0,0 +1,27 @@
+#ifndef _IRQLAT_H
+#define _IRQLAT_H
+
+// 关中断时间统计，编译时打开 IRQ_LATENCY 选项（见 Option.mk）才有，由 kernel/irqlat.c 实现
+// 打开后 <asm/system.h> 中的 cli()、sti() 和 restore_flags() 变成函数调用，
+// 记录从关中断到开中断的每一段时间（CPU 周期数）以及两端的调用地址（可以对照 System.map 查找所在函数）
+// 通过 /dev/irqlat（主设备号 1，次设备号 9）读出 NR_IRQLAT 项 irqlat_entry 结构，
+// 按最长时间从大到小排列，第 0 项就是最坏的关中断代码段。写该设备则把统计清零
+
+// 统计表的项数，满了以后新的关中断地址只有比最后一项更长时才替换它
+#define NR_IRQLAT 32
+
+struct irqlat_entry
+{
+	unsigned long off_site;	 // 关中断的地址，即 cli() 的返回地址，0 表示空项
+	unsigned long on_site;	 // 最长一次对应的开中断地址
+	unsigned long count;	 // 从该地址关中断的次数
+	unsigned long max_pid;	 // 最长一次发生时的当前进程号
+	unsigned long long max;	 // 最长一次关中断的时间，CPU 没有 TSC 时为 0
+	unsigned long long total; // 总的关中断时间
+};
+
+// 统计表，/dev/irqlat 的读操作直接复制它
+extern struct irqlat_entry irqlat[NR_IRQLAT];
+extern int irqlat_write(char *buf, int count);
+
+#endif
@@ -12,6 +12,12 @@ int printf(const char *fmt, ...);
 // 内核专用的打印信息函数，功能与 printf() 相同
 int printk(const char *fmt, ...);
 
+// printk() 的消息先放在日志缓冲区中，由时钟中断输出到控制台，见 kernel/printk.c
+void log_timer(long cpl);
+
+// 立即把日志缓冲区中还没输出的消息写到控制台
+void console_flush(void);
+
 // 往 tty 上写指定长度的字符串
 int tty_write(unsigned ch, char *buf, int count);
 
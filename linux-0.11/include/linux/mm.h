@@ -10,7 +10,36 @@ extern unsigned long get_free_page(void);
 // 在指定物理地址处放置一页面，在页目录和页表中放置指定页面信息
 extern unsigned long put_page(unsigned long page, unsigned long address);
 
+// 将已被引用的页面再映射到指定线性地址处，并增加页面的引用次数，用于共享内存段
+extern unsigned long put_shared_page(unsigned long page, unsigned long address);
+
 // 释放物理地址 addr 开始的一页面内存，修改页面映射数组 mem_map[] 中引用次数信息
 extern void free_page(unsigned long addr);
 
+// 取线性地址对应的物理地址，页面不存在则返回 0
+extern unsigned long get_phys_addr(unsigned long address);
+
+// 置线性地址对应页面的已修改（dirty）标志，用于内核绕过页表写入的页面
+extern void set_page_dirty(unsigned long address);
+
+// 统计主内存区的页面：总页数，空闲页数，被共享的页数，被内核保留的页数（如虚拟盘）
+extern void mem_usage(unsigned long *total, unsigned long *free,
+					  unsigned long *shared, unsigned long *reserved);
+
+// 统计线性地址 from 开始 size 字节范围内存在的页面数
+extern unsigned long count_pages(unsigned long from, unsigned long size);
+
+// 释放指定线性地址范围内的页面，并清除对应的页表项，用于撤销文件映射区
+extern void free_page_range(unsigned long from, unsigned long size);
+
+// 文件映射区（mmap）在进程 64MB 地址空间中的范围
+// 执行文件代码段 + 数据段 + bss 段最多 46MB，而堆栈位于空间的最末端
+#define MMAP_START 0x3000000
+#define MMAP_END 0x3c00000
+
+// 共享内存段（shmat）的附加区紧接在文件映射区之下，分成 NR_SHM_ATTACH 个槽，每槽 SHMMAX 字节
+// 共享内存段最大为 SHMMAX 字节，第 i 个附加的段映射在 SHM_START + i * SHMMAX 处
+#define SHMMAX 0x40000
+#define SHM_START 0x2e00000
+
 #endif
@@ -108,6 +108,42 @@ struct tss_struct
 	struct i387_struct i387;
 };
 
+// 每个进程最多可以建立的文件映射区数
+#define NR_MMAP 8
+
+// 进程的文件映射区描述结构，由 mmap() 建立，munmap() 撤销
+// 地址均是相对于进程基址（start_code）的偏移，并以页面为边界
+struct mmap_struct
+{
+	unsigned long start;	// 映射区起始地址
+	unsigned long end;		// 映射区结束地址（不含）
+	unsigned long offset;	// 映射区起始处对应的文件偏移
+	unsigned short prot;	// 访问保护标志 PROT_*
+	unsigned short flags;	// 映射类型 MAP_SHARED / MAP_PRIVATE
+	struct m_inode *inode;	// 被映射文件的 i 节点，为空表示该项空闲
+};
+
+// 查找当前进程中包含地址 addr（相对进程基址）的文件映射区，没有则返回 NULL
+extern struct mmap_struct *find_mmap(unsigned long addr);
+// 撤销当前进程的所有文件映射区，在 exit() 和 execve() 时调用
+extern void exit_mmap(void);
+
+// 每个进程最多可以附加的共享内存段数（SHM_START 开始的附加槽数）
+#define NR_SHM_ATTACH 8
+
+// 判断当前进程的地址 addr（相对进程基址）是否位于附加的共享内存段中
+extern int find_shm(unsigned long addr);
+// 子进程继承父进程附加的共享内存段，增加各段的附加计数，在 fork() 时调用
+extern void fork_shm(struct task_struct *p);
+// 分离当前进程附加的所有共享内存段，在 exit() 和 execve() 时调用
+// 页面由调用者通过 free_page_tables() 释放
+extern void exit_shm(void);
+
+// 进程的异步 I/O 上下文，定义在 fs/aio.c 中
+struct aio_context;
+// 撤销当前进程的异步 I/O 上下文，在 exit() 和 execve() 时调用
+extern void exit_aio(void);
+
 // 这里是任务（进程）数据结构，或称为进程描述符
 struct task_struct
 {
@@ -186,6 +222,29 @@ struct task_struct
 
 	// 本进程的任务状态段信息结构
 	struct tss_struct tss;
+
+	// 文件映射区表，放在结构末尾，以免影响汇编中使用的字段偏移
+	struct mmap_struct mmap[NR_MMAP];
+
+	// 异步 I/O 上下文，第一次调用 aio_submit() 时分配，不被子进程继承
+	struct aio_context *aio;
+
+	// 睡眠超时时刻（滴答数），到时由 schedule() 唤醒可中断睡眠的进程，0 表示没有设置
+	long timeout;
+
+	// 各附加槽上附加的共享内存段标识符加 1，0 表示该槽空闲
+	unsigned char shm[NR_SHM_ATTACH];
+
+	// profil() 设置的用户态 PC 采样：计数缓冲区，缓冲区字节数，起始程序地址，比例因子
+	// prof_scale 为 0 表示没有采样。fork() 时被子进程继承，execve() 时撤销
+	unsigned short *prof_buf;
+	unsigned long prof_size, prof_off, prof_scale;
+
+#ifdef SYSCALL_STATS
+	// 正在执行的系统调用号及其开始时刻（时间戳计数器的值），见 kernel/sysstat.c
+	long sys_nr;
+	unsigned long long sys_start;
+#endif
 };
 
 // INIT_TASK 用于设置第1 个任务表，若想修改，责任自负 😊
@@ -303,6 +362,15 @@ extern void interruptible_sleep_on(struct task_struct **p);
 // 明确唤醒睡眠的进程
 extern void wake_up(struct task_struct **p);
 
+// 内核态 PC 采样直方图：计数数组，计数个数，每个计数对应的代码字节数的对数，见 kernel/sched.c
+extern unsigned long *prof_buffer;
+extern unsigned long prof_len;
+extern unsigned long prof_shift;
+
+// 正在 select()/poll() 中登记等待的项数，以及唤醒在等待队列 p 上登记的进程，在 fs/select.c 中
+extern int select_nr;
+extern void select_wake(struct task_struct **p);
+
 // 寻找第 1 个 TSS 在全局表中的入口
 // 0-没有用 nul，
 // 1-代码段 cs，
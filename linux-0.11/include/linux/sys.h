@@ -72,6 +72,29 @@ extern int sys_sgetmask();  // 取信号屏蔽码
 extern int sys_ssetmask();  // 设置信号屏蔽码
 extern int sys_setreuid();  // 设置真实与/或有效用户 id
 extern int sys_setregid();  // 设置真实与/或有效组 id
+extern int sys_mmap();      // 映射文件到进程空间
+extern int sys_munmap();    // 撤销文件映射
+extern int sys_sendfile();  // 在两个文件之间直接传送数据
+extern int sys_readv();     // 分散读
+extern int sys_writev();    // 集中写
+extern int sys_pread();     // 在指定位置读文件
+extern int sys_pwrite();    // 在指定位置写文件
+extern int sys_aio_submit(); // 提交异步读写操作
+extern int sys_aio_getevents(); // 取异步读写完成事件
+extern int sys_select();    // 等待多个文件就绪
+extern int sys_poll();      // 等待多个文件上的事件
+extern int sys_shmget();    // 取得共享内存段
+extern int sys_shmat();     // 附加共享内存段
+extern int sys_shmdt();     // 分离共享内存段
+extern int sys_shmctl();    // 控制（删除）共享内存段
+extern int sys_futex_wait(); // 在用户空间长字上等待
+extern int sys_futex_wake(); // 唤醒在用户空间长字上等待的进程
+extern int sys_socket();    // 建立套接字
+extern int sys_bind();      // 为套接字绑定名字
+extern int sys_listen();    // 在套接字上监听连接
+extern int sys_accept();    // 接受连接
+extern int sys_connect();   // 连接到监听的套接字
+extern int sys_syslog();    // 读出或清除内核日志缓冲区
 
 fn_ptr sys_call_table[] = {
     sys_setup,
@@ -146,4 +169,27 @@ fn_ptr sys_call_table[] = {
     sys_ssetmask,
     sys_setreuid,
     sys_setregid,
+    sys_mmap,
+    sys_munmap,
+    sys_sendfile,
+    sys_readv,
+    sys_writev,
+    sys_pread,
+    sys_pwrite,
+    sys_aio_submit,
+    sys_aio_getevents,
+    sys_select,
+    sys_poll,
+    sys_shmget,
+    sys_shmat,
+    sys_shmdt,
+    sys_shmctl,
+    sys_futex_wait,
+    sys_futex_wake,
+    sys_socket,
+    sys_bind,
+    sys_listen,
+    sys_accept,
+    sys_connect,
+    sys_syslog,
 };
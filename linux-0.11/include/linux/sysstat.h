@@ -0,0 +1,24 @@
+#ifndef _SYSSTAT_H
+#define _SYSSTAT_H
+
+// 系统调用统计，编译时打开 SYSCALL_STATS 选项（见 Option.mk）才有，由 kernel/sysstat.c 实现
+// 通过 /dev/sysstat（主设备号 1，次设备号 7）读出 NR_SYSSTAT 项 syscall_stat 结构，第 i 项对应调用号 i
+// 写该设备则把统计清零
+
+// 统计表的项数，大于系统调用数
+#define NR_SYSSTAT 128
+
+// 耗时分布的格数：第 i 格统计耗时在 [2^i, 2^(i+1)) 个 CPU 周期内的调用次数（第 0 格包括 0）
+#define NR_SYSSTAT_HIST 32
+
+struct syscall_stat
+{
+	unsigned long count;				 // 调用次数
+	unsigned long hist[NR_SYSSTAT_HIST]; // 从进入系统调用到 ret_from_sys_call 的耗时分布，CPU 没有 TSC 时为 0
+};
+
+// 统计表，/dev/sysstat 的读操作直接复制它
+extern struct syscall_stat sysstat[NR_SYSSTAT];
+extern int sysstat_write(char *buf, int count);
+
+#endif
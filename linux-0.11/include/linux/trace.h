@@ -0,0 +1,47 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+// 内核跟踪事件，记录在 kernel/trace.c 的环形缓冲区中，通过 /dev/trace（主设备号 1，次设备号 6）读出
+// 下面是事件类型，以及各事件参数 a、b 的含义
+#define TRACE_LOST 0		// 缓冲区满，有事件被覆盖：a - 丢失的事件数
+#define TRACE_SWITCH 1		// 任务切换：a - 切换出的进程号，b - 切换到的进程号
+#define TRACE_SLEEP 2		// 在等待队列上睡眠：a - 等待队列地址，b - 1 表示可中断睡眠
+#define TRACE_WAKEUP 3		// 唤醒等待队列：a - 等待队列地址，b - 被唤醒的进程号
+#define TRACE_GETBLK_HIT 4	// getblk() 在高速缓冲中找到了块：a - 设备号，b - 块号
+#define TRACE_GETBLK_MISS 5 // getblk() 为块分配了新的缓冲区：a - 设备号，b - 块号
+#define TRACE_BLK_REQUEST 6 // 请求项加入设备的请求队列：a - 命令 << 16 | 设备号，b - 起始扇区
+#define TRACE_BLK_END 7		// 请求项处理完毕：a - 成功标志 << 16 | 设备号，b - 起始扇区
+#define TRACE_PAGE_FAULT 8	// 页异常：a - 线性地址，b - 出错码
+#define TRACE_SYSCALL 9		// 进入系统调用：a - 调用号，b - 第 1 个参数
+#define TRACE_SYSRET 10		// 系统调用返回：a - 返回值
+
+// 跟踪记录，每项 24 字节
+struct trace_entry
+{
+	unsigned long long tsc; // 时间戳计数器（TSC）的值，CPU 没有 TSC 时为 0
+	unsigned long jiffies;	// 滴答数
+	unsigned short event;	// 事件类型
+	unsigned short pid;		// 当前进程号
+	unsigned long a, b;		// 事件参数
+};
+
+// 是否打开了跟踪，向 /dev/trace 写入 '1' 打开、写入 '0' 关闭
+extern int trace_on;
+extern void trace_event(int event, unsigned long a, unsigned long b);
+
+// 跟踪点，关闭跟踪时只有一次比较
+#define trace(event, a, b)                                              \
+	do                                                                  \
+	{                                                                   \
+		if (trace_on)                                                   \
+			trace_event((event), (unsigned long)(a), (unsigned long)(b)); \
+	} while (0)
+
+// CPU 是否有时间戳计数器（可以使用 rdtsc 指令）
+extern int has_tsc(void);
+
+// /dev/trace 的读写函数
+extern int trace_read(char *buf, int count);
+extern int trace_write(char *buf, int count);
+
+#endif
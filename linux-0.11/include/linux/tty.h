@@ -13,6 +13,22 @@
 // tty 缓冲区（缓冲队列）大小
 #define TTY_BUF_SIZE 1024
 
+// 虚拟控制台的最多个数，实际个数由显示内存的大小决定（见 console.c）
+// 控制台 0 的终端号是 0，其余控制台 n 的终端号（主设备号 4 下的次设备号）是 2+n，排在两个串口终端之后
+#define NR_CONSOLES 4
+#define CON_TTY(n) ((n) ? 2 + (n) : 0)					// 控制台 n 的终端号
+#define TTY_CON(ch) ((ch) ? (ch) - 2 : 0)				// 控制台终端 ch 的控制台号
+
+// 伪终端的个数。主设备号都是 4：从端的次设备号从 PTY_SLAVE 开始，也是它在 tty_table 中的下标；
+// 主端的次设备号从 PTY_MASTER 开始，见 kernel/chr_drv/pty.c
+#define NR_PTY 8
+#define PTY_SLAVE (2 + NR_CONSOLES)
+#define PTY_MASTER 128
+#define NR_TTY (PTY_SLAVE + NR_PTY) // tty_table 的项数
+
+#define IS_PTY_SLAVE(minor) ((minor) >= PTY_SLAVE && (minor) < NR_TTY)
+#define IS_PTY_MASTER(minor) ((minor) >= PTY_MASTER && (minor) < PTY_MASTER + NR_PTY)
+
 // tty 等待队列数据结构。用于tty_struc 结构中的读、写和辅助（规范）缓冲队列
 struct tty_queue
 {
@@ -63,6 +79,11 @@ struct tty_queue
 			INC((queue).head);               \
 		})
 
+// 原始输入模式：规范模式、信号字符、回显和输入字符转换都没有设置，输入不需要任何行规程处理
+// 此时输入字符留在读队列中，由 tty_read() 成块地直接复制给用户，不再经过辅助队列
+#define RAW_INPUT(tty) (!((tty)->termios.c_lflag & (ICANON | ISIG | ECHO)) && \
+						!((tty)->termios.c_iflag & (ICRNL | INLCR | IGNCR | IUCLC)))
+
 // 判断终端键盘字符类型
 #define INTR_CHAR(tty) ((tty)->termios.c_cc[VINTR])	   // 中断符
 #define QUIT_CHAR(tty) ((tty)->termios.c_cc[VQUIT])	   // 退出符
@@ -87,6 +108,16 @@ struct tty_struct
 
 extern struct tty_struct tty_table[]; // tty 结构数组
 
+// 伪终端主端的状态，从端使用 tty_table[PTY_SLAVE + n]
+struct pty_struct
+{
+	int master;				  // 主端已打开，伪终端正在使用
+	struct task_struct *wait; // 等待从端输出的读主端进程
+};
+
+extern struct pty_struct pty_table[];
+extern unsigned long rs_fifo_size[];  // 各串口每次发送中断最多送出的字符数，在 serial.c 中
+
 /*	intr=^C		quit=^|		erase=del	kill=^U
 	eof=^D		vtime=\0	vmin=\1		sxtc=\0
 	start=^Q	stop=^S		susp=^Z		eol=\0
@@ -113,7 +144,19 @@ int tty_write(unsigned c, char *buf, int n);
 
 void rs_write(struct tty_struct *tty);
 void con_write(struct tty_struct *tty);
+void change_console(int nr);
+
+void pty_write(struct tty_struct *tty);
 
 void copy_to_cooked(struct tty_struct *tty);
+int copy_queue_to_user(struct tty_queue *queue, char *buf, int nr);
+void tty_intr(struct tty_struct *tty, int mask);
+
+int pty_open(int minor);
+void pty_close(int minor);
+int pty_master_read(unsigned n, char *buf, int nr);
+int pty_master_write(unsigned n, char *buf, int nr);
+int pty_poll(unsigned n, struct task_struct ***rq, struct task_struct ***wq);
+void change_speed(struct tty_struct *tty);
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef _SYS_AIO_H
+#define _SYS_AIO_H
+
+#include <sys/types.h>
+
+// 异步 I/O 操作码
+#define AIO_READ 0	// 读
+#define AIO_WRITE 1 // 写
+
+// 每个进程同时可以进行的异步 I/O 操作数，与块设备请求项数 NR_REQUEST 相同，
+// 因此一个进程就可以把请求队列全部填满
+#define AIO_MAX 32
+// 每个异步 I/O 操作最多涉及的数据块数，读写位置不必对齐，因此最大长度要少一块
+#define AIO_MAX_BLOCKS 8
+#define AIO_MAX_BYTES ((AIO_MAX_BLOCKS - 1) * 1024)
+
+// 异步 I/O 控制块，由用户程序填写后通过 aio_submit() 批量提交
+struct aiocb
+{
+	int aio_fildes;		   // 文件描述符（常规文件或块设备）
+	int aio_lio_opcode;	   // 操作码 AIO_READ / AIO_WRITE
+	char *aio_buf;		   // 用户缓冲区
+	off_t aio_offset;	   // 文件中的读写位置
+	size_t aio_nbytes;	   // 读写字节数
+	unsigned long aio_data; // 用户数据，原样在完成事件中返回
+};
+
+// 完成事件，由 aio_getevents() 从进程的完成环中取出
+struct aio_event
+{
+	unsigned long data; // 对应控制块中的 aio_data
+	int res;			// 读写的字节数，出错则为出错码（负值）
+};
+
+extern int aio_submit(struct aiocb *list, int nr);
+extern int aio_getevents(struct aio_event *events, int nr, int min_nr);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef _SYS_FUTEX_H
+#define _SYS_FUTEX_H
+
+// 用户空间同步原语的等待和唤醒，uaddr 必须是共享内存中长字对齐的地址
+// 没有竞争时用户程序直接用原子指令操作该长字，只在需要等待或有等待者时才调用
+extern int futex_wait(unsigned long *uaddr, unsigned long val);
+extern int futex_wake(unsigned long *uaddr, int nr);
+
+#endif
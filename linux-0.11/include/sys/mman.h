@@ -0,0 +1,36 @@
+#ifndef _SYS_MMAN_H
+#define _SYS_MMAN_H
+
+#include <sys/types.h>
+
+// 映射区的访问保护标志
+#define PROT_NONE 0x0  // 页面不可访问（不支持，mmap() 返回 EINVAL）
+#define PROT_READ 0x1  // 页面可读
+#define PROT_WRITE 0x2 // 页面可写
+#define PROT_EXEC 0x4  // 页面可执行
+
+// 映射类型，两者只能使用其一
+#define MAP_SHARED 0x01	 // 与其它映射该文件的进程共享页面（只读）
+#define MAP_PRIVATE 0x02 // 私有映射，写时复制
+#define MAP_TYPE 0x0f	 // 映射类型屏蔽码
+#define MAP_FIXED 0x10	 // 必须映射到指定的地址处
+
+// mmap() 出错时的返回值
+#define MAP_FAILED ((void *)-1)
+
+// mmap 有 6 个参数，而系统调用最多只能通过寄存器传递 3 个，
+// 因此通过指向下面结构的指针传递给内核
+struct mmap_arg_struct
+{
+	unsigned long addr;
+	unsigned long len;
+	unsigned long prot;
+	unsigned long flags;
+	unsigned long fd;
+	unsigned long offset;
+};
+
+extern void *mmap(void *addr, size_t len, int prot, int flags, int fd, off_t offset);
+extern int munmap(void *addr, size_t len);
+
+#endif
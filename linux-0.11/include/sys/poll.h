@@ -0,0 +1,24 @@
+#ifndef _SYS_POLL_H
+#define _SYS_POLL_H
+
+// poll() 中关心的事件和返回的事件
+#define POLLIN 0x0001	// 有数据可读
+#define POLLPRI 0x0002	// 有紧急数据可读（不支持）
+#define POLLOUT 0x0004	// 可以写入数据
+#define POLLERR 0x0008	// 出错（只在 revents 中返回）
+#define POLLHUP 0x0010	// 对端已关闭（只在 revents 中返回）
+#define POLLNVAL 0x0020 // 文件描述符无效（只在 revents 中返回）
+
+// poll() 一次最多可以等待的文件描述符数
+#define NR_POLL 20
+
+struct pollfd
+{
+	int fd;			// 文件描述符，负值表示忽略该项
+	short events;	// 关心的事件
+	short revents;	// 返回的事件
+};
+
+extern int poll(struct pollfd *fds, unsigned long nfds, int timeout);
+
+#endif
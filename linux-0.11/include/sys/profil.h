@@ -0,0 +1,22 @@
+#ifndef _SYS_PROFIL_H
+#define _SYS_PROFIL_H
+
+#include <sys/types.h>
+
+// profil() 的比例因子：计数缓冲区中每个 unsigned short 对应程序中 2 字节时为 0x10000，
+// 0x8000 对应 4 字节，依此类推；为 0 或 1 时关闭采样
+#define PROFIL_SCALE_1TO1 0x10000
+
+// profil 有 4 个参数，而系统调用最多只能通过寄存器传递 3 个，
+// 因此通过指向下面结构的指针传递给内核
+struct prof_arg_struct
+{
+	unsigned short *buf;  // 计数缓冲区
+	unsigned long size;	  // 缓冲区字节数
+	unsigned long offset; // 缓冲区第一个计数对应的程序地址
+	unsigned long scale;  // 比例因子
+};
+
+extern int profil(unsigned short *buf, size_t bufsiz, size_t offset, unsigned int scale);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef _SYS_SELECT_H
+#define _SYS_SELECT_H
+
+#include <sys/types.h>
+
+// 文件描述符集，每个比特位对应一个文件描述符，进程最多打开 NR_OPEN(20) 个文件，一个长字就够了
+typedef unsigned long fd_set;
+
+#define FD_SETSIZE (8 * sizeof(fd_set))
+#define FD_SET(fd, fdsetp) (*(fdsetp) |= (1UL << (fd)))
+#define FD_CLR(fd, fdsetp) (*(fdsetp) &= ~(1UL << (fd)))
+#define FD_ISSET(fd, fdsetp) ((*(fdsetp) >> (fd)) & 1)
+#define FD_ZERO(fdsetp) (*(fdsetp) = 0)
+
+// select() 的超时时间
+struct timeval
+{
+	long tv_sec;  // 秒
+	long tv_usec; // 微秒
+};
+
+// select 有 5 个参数，而系统调用最多只能通过寄存器传递 3 个，
+// 因此通过指向下面结构的指针传递给内核
+struct select_arg_struct
+{
+	unsigned long n;
+	fd_set *readfds;
+	fd_set *writefds;
+	fd_set *exceptfds;
+	struct timeval *timeout;
+};
+
+extern int select(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+				  struct timeval *timeout);
+
+#endif
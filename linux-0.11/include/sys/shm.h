@@ -0,0 +1,21 @@
+#ifndef _SYS_SHM_H
+#define _SYS_SHM_H
+
+#include <sys/types.h>
+
+// shmget() 的键值和标志，标志的低 9 位是新段的访问权限（含义同文件的权限位）
+#define IPC_PRIVATE 0	 // 总是建立新的共享内存段
+#define IPC_CREAT 01000	 // 若不存在则建立
+#define IPC_EXCL 02000	 // 与 IPC_CREAT 一起使用，若已存在则出错
+
+// shmctl() 的命令
+#define IPC_RMID 0 // 删除共享内存段，最后一个进程分离后释放其页面
+
+typedef long key_t;
+
+extern int shmget(key_t key, int size, int shmflg);
+extern void *shmat(int shmid, const void *shmaddr, int shmflg);
+extern int shmdt(const void *shmaddr);
+extern int shmctl(int shmid, int cmd, void *buf);
+
+#endif
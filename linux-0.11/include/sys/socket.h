@@ -0,0 +1,28 @@
+#ifndef _SYS_SOCKET_H
+#define _SYS_SOCKET_H
+
+#include <sys/types.h>
+
+// 地址族，目前只支持本机内的 UNIX 域
+#define AF_UNIX 1
+
+// 套接字类型，目前只支持字节流
+#define SOCK_STREAM 1
+
+// 监听套接字等待接受的连接数上限
+#define SOMAXCONN 5
+
+// 通用的套接字地址
+struct sockaddr
+{
+	unsigned short sa_family; // 地址族 AF_*
+	char sa_data[14];		  // 地址数据
+};
+
+extern int socket(int domain, int type, int protocol);
+extern int bind(int fd, struct sockaddr *addr, int addrlen);
+extern int listen(int fd, int backlog);
+extern int accept(int fd, struct sockaddr *addr, int *addrlen);
+extern int connect(int fd, struct sockaddr *addr, int addrlen);
+
+#endif
@@ -26,6 +26,7 @@ struct stat
 #define S_IFDIR 0040000 // 目录文件
 #define S_IFCHR 0020000 // 字符设备文件
 #define S_IFIFO 0010000 // FIFO 特殊文件
+#define S_IFSOCK 0140000 // 套接字（绑定 UNIX 域套接字时建立的名字节点）
 
 // 文件属性位：
 // S_ISUID 用于测试文件的 set-user-ID 标志是否置位
@@ -40,6 +41,7 @@ struct stat
 #define S_ISCHR(m) (((m)&S_IFMT) == S_IFCHR)  // 是否字符设备文件
 #define S_ISBLK(m) (((m)&S_IFMT) == S_IFBLK)  // 是否块设备文件
 #define S_ISFIFO(m) (((m)&S_IFMT) == S_IFIFO) // 是否FIFO 特殊文件
+#define S_ISSOCK(m) (((m)&S_IFMT) == S_IFSOCK) // 是否套接字
 
 // 文件访问权限
 #define S_IRWXU 00700 // 宿主可以读、写、执行/搜索
@@ -0,0 +1,16 @@
+#ifndef _SYS_SYSLOG_H
+#define _SYS_SYSLOG_H
+
+// syslog() 系统调用的操作，读写内核的 printk 日志缓冲区，见 kernel/printk.c
+#define SYSLOG_ACTION_CLOSE 0		// 什么也不做
+#define SYSLOG_ACTION_OPEN 1		// 什么也不做
+#define SYSLOG_ACTION_READ 2		// 取走还没读过的消息，没有时等待
+#define SYSLOG_ACTION_READ_ALL 3	// 读出缓冲区中（上次清除以后）最后 len 个字节，不取走
+#define SYSLOG_ACTION_READ_CLEAR 4	// 同上，读出后清除
+#define SYSLOG_ACTION_CLEAR 5		// 清除，以后 READ_ALL 只读出清除之后的消息
+#define SYSLOG_ACTION_SIZE_UNREAD 9 // 还没读过的字节数
+#define SYSLOG_ACTION_SIZE_BUFFER 10 // 缓冲区长度
+
+extern int syslog(int type, char *buf, int len);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _SYS_UIO_H
+#define _SYS_UIO_H
+
+#include <sys/types.h>
+
+// readv()/writev() 一次最多可以使用的缓冲区个数
+#define UIO_MAXIOV 16
+
+// 分散读/集中写使用的缓冲区描述结构
+struct iovec
+{
+	void *iov_base; // 缓冲区起始地址
+	size_t iov_len; // 缓冲区长度（字节数）
+};
+
+extern int readv(int fildes, const struct iovec *iov, int iovcnt);
+extern int writev(int fildes, const struct iovec *iov, int iovcnt);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef _SYS_UN_H
+#define _SYS_UN_H
+
+// UNIX 域套接字的地址，名字是文件系统中的一个路径名
+struct sockaddr_un
+{
+	unsigned short sun_family; // AF_UNIX
+	char sun_path[108];		   // 以 NULL 结尾的路径名
+};
+
+#endif
@@ -208,7 +208,7 @@ struct termios
 #define FF1 0040000	   // 换页延迟类型 1
 
 // termios 结构中控制模式标志字段 c_cflag 标志的符号常数（8 进制数）
-#define CBAUD 0000017  // 传输速率位屏蔽码
+#define CBAUD 0010017  // 传输速率位屏蔽码
 #define B0 0000000	   // 挂断线路
 #define B50 0000001	   // 波特率 50
 #define B75 0000002	   // 波特率 75
@@ -227,6 +227,9 @@ struct termios
 #define B38400 0000017 // 波特率 38400
 #define EXTA B19200	   // 扩展波特率 A
 #define EXTB B38400	   // 扩展波特率 B
+#define CBAUDEX 0010000 // 扩展传输速率标志，与低 4 位一起选择 38400 以上的波特率
+#define B57600 0010001	// 波特率 57600
+#define B115200 0010002 // 波特率 115200
 
 #define CSIZE 0000060		 // 字符位宽度屏蔽码
 #define CS5 0000000			 // 每字符5 比特位
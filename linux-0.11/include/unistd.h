@@ -147,6 +147,29 @@
 #define __NR_ssetmask 69
 #define __NR_setreuid 70
 #define __NR_setregid 71
+#define __NR_mmap 72
+#define __NR_munmap 73
+#define __NR_sendfile 74
+#define __NR_readv 75
+#define __NR_writev 76
+#define __NR_pread 77
+#define __NR_pwrite 78
+#define __NR_aio_submit 79
+#define __NR_aio_getevents 80
+#define __NR_select 81
+#define __NR_poll 82
+#define __NR_shmget 83
+#define __NR_shmat 84
+#define __NR_shmdt 85
+#define __NR_shmctl 86
+#define __NR_futex_wait 87
+#define __NR_futex_wake 88
+#define __NR_socket 89
+#define __NR_bind 90
+#define __NR_listen 91
+#define __NR_accept 92
+#define __NR_connect 93
+#define __NR_syslog 94
 
 // 以下定义系统调用内联汇编宏函数
 // 不带参数的系统调用宏函数，type name(void)
@@ -277,6 +300,9 @@ int utime(const char *filename, struct utimbuf *times);
 pid_t waitpid(pid_t pid, int *wait_stat, int options);
 pid_t wait(int *wait_stat);
 int write(int fildes, const char *buf, off_t count);
+int sendfile(int out_fd, int in_fd, off_t *offset, off_t count);
+int pread(int fildes, char *buf, off_t count, off_t offset);
+int pwrite(int fildes, const char *buf, off_t count, off_t offset);
 int dup2(int oldfd, int newfd);
 int getppid(void);
 pid_t getpgrp(void);
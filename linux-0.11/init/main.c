@@ -91,6 +91,9 @@ static inline _syscall0(int, fork)
 // 文件系统头文件，定义文件表结构（file,buffer_head,m_inode 等）
 #include <linux/fs.h>
 
+// 启动过程的时间记录
+#include <linux/bootlog.h>
+
 	// 静态字符串数组，用作内核显示信息的缓存
 	static char printbuf[1024];
 
@@ -118,6 +121,9 @@ extern void mem_init(long start, long end);
 // 虚拟盘初始化
 extern long rd_init(long mem_start, int length);
 
+// 内核 PC 采样直方图初始化
+extern long prof_init(long mem_start, int shift);
+
 // 计算系统开机启动时间（秒）
 extern long kernel_mktime(struct tm *tm);
 
@@ -208,6 +214,9 @@ void main(void)
 	// 机器内存数 -> memory_end；
 	// 主内存开始地址 -> main_memory_start；
 
+	// 先复制 bootsect/setup 记下的启动时间，它们和下面的参数一样，之后会被高速缓冲覆盖
+	boot_log_init();
+
 	ROOT_DEV = ORIG_ROOT_DEV;
 
 	// 复制0x90080 处的硬盘参数表。
@@ -238,38 +247,53 @@ void main(void)
 	main_memory_start += rd_init(main_memory_start, RAMDISK * 1024);
 #endif
 
+#ifdef PROF_SHIFT
+	// 如果定义了内核 PC 采样，则分配采样直方图。此时主内存将减少
+	main_memory_start += prof_init(main_memory_start, PROF_SHIFT);
+#endif
+
 	// 以下是内核进行所有方面的初始化工作。
 	// 阅读时最好跟着调用的程序深入进去看，若实在看不下去了
 	// 就先放一放，继续看下一个初始化调用，这是经验之谈 😜。
 
 	mem_init(main_memory_start, memory_end);
+	boot_stamp("mem_init");
 
 	// 陷阱门（硬件中断向量）初始化
 	trap_init();
+	boot_stamp("trap_init");
 
 	// 块设备初始化
 	blk_dev_init();
+	boot_stamp("blk_dev_init");
 
 	// 字符设备初始化
 	chr_dev_init();
+	boot_stamp("chr_dev_init");
 
 	// tty 初始化
 	tty_init();
+	boot_stamp("tty_init");
 
 	// 设置开机启动时间 -> startup_time
 	time_init();
+	boot_stamp("time_init");
 
 	// 调度程序初始化
 	sched_init();
+	boot_stamp("sched_init");
 
 	// 缓冲管理初始化，建内存链表等
 	buffer_init(buffer_memory_end);
+	boot_stamp("buffer_init");
 
 	// 硬盘初始化
 	hd_init();
+	boot_stamp("hd_init");
 
 	// 软驱初始化
 	floppy_init();
+	boot_stamp("floppy_init");
 
 	// 所有初始化工作都做完了，开启中断
 	sti();
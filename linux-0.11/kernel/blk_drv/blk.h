@@ -1,6 +1,8 @@
 #ifndef _BLK_H
 #define _BLK_H
 
+#include <linux/trace.h>
+
 // 块设备的数量
 #define NR_BLK_DEV 7
 
@@ -24,6 +26,7 @@ struct request
 	int errors;					 //操作时产生的错误次数
 	unsigned long sector;		 // 起始扇区。(1 块=2 扇区)
 	unsigned long nr_sectors;	 // 读/写扇区数
+	unsigned long start_sector;	 // 加入队列时的起始扇区，驱动程序会前移 sector，结束时的跟踪记录用这个值
 	char *buffer;				 // 数据缓冲区
 	struct task_struct *waiting; // 任务等待操作执行完成的地方
 	struct buffer_head *bh;		 // 缓冲区头指针
@@ -173,6 +176,7 @@ static inline void unlock_buffer(struct buffer_head *bh)
 // 释放并从请求链表中删除本请求项
 static inline void end_request(int uptodate)
 {
+	trace(TRACE_BLK_END, (uptodate << 16) | CURRENT->dev, CURRENT->start_sector);
 	DEVICE_OFF(CURRENT->dev); // 关闭设备
 
 	if (CURRENT->bh) // CURRENT 为指定主设备号的当前请求结构
@@ -186,12 +190,22 @@ static inline void end_request(int uptodate)
 	if (!uptodate) // 如果更新标志为 0 则显示设备错误信息
 	{
 		printk(DEVICE_NAME " I/O error\n\r");
-		printk("dev %04x, block %d\n\r", CURRENT->dev,
-			   CURRENT->bh->b_blocknr);
+		if (CURRENT->bh)
+			printk("dev %04x, block %d\n\r", CURRENT->dev,
+				   CURRENT->bh->b_blocknr);
+		else
+			printk("dev %04x, sector %d\n\r", CURRENT->dev,
+				   CURRENT->sector);
 	}
 	wake_up(&CURRENT->waiting); // 唤醒等待该请求项的进程
 	wake_up(&wait_for_request); // 唤醒等待请求的进程
-	CURRENT->dev = -1;			// 释放该请求项
+
+	// 没有缓冲块的请求项（直接 I/O）由发出请求的进程在取得结果后释放，
+	// 结果放在 errors 中：0 - 成功，-1 - 出错
+	if (CURRENT->bh)
+		CURRENT->dev = -1; // 释放该请求项
+	else
+		CURRENT->errors = uptodate ? 0 : -1;
 
 	// 从请求链表中删除该请求项，并且当前请求项指针指向下一个请求项
 	CURRENT = CURRENT->next;
@@ -13,6 +13,7 @@
 #include <linux/fs.h>
 #include <linux/kernel.h>
 #include <linux/hdreg.h>
+#include <linux/bootlog.h>
 #include <asm/system.h>
 #include <asm/io.h>
 #include <asm/segment.h>
@@ -218,12 +219,15 @@ int sys_setup(void *BIOS)
 	// 如果有硬盘存在并且已读入分区表，则打印分区表正常信息
 	if (NR_HD)
 		printk("Partition table%s ok.\n\r", (NR_HD > 1) ? "s" : "");
+	boot_stamp("partitions");
 
 	// 加载（创建）RAMDISK
 	rd_load();
+	boot_stamp("rd_load");
 
 	// 安装根文件系统
 	mount_root();
+	boot_stamp("mount_root");
 	return (0);
 }
 
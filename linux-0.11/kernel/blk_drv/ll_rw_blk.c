@@ -76,6 +76,9 @@ static void add_request(struct blk_dev_struct *dev, struct request *req)
 	struct request *tmp;
 
 	req->next = NULL;
+	req->start_sector = req->sector;
+	trace(TRACE_BLK_REQUEST, (req->cmd << 16) | req->dev, req->sector);
+	blk_stat.requests[MAJOR(req->dev)]++;
 	cli(); // 关中断
 	if (req->bh)
 		req->bh->b_dirt = 0; // 清缓冲区 脏 标志
@@ -179,6 +182,7 @@ repeat:
 		}
 
 		// 否则让本次请求睡眠，过会再查看请求队列
+		blk_stat.request_wait++;
 		sleep_on(&wait_for_request);
 		goto repeat;
 	}
@@ -243,6 +247,104 @@ void ll_rw_block(int rw, struct buffer_head *bh)
 }
 
 
+// 直接 I/O：不经过高速缓冲，在内存 buffer 与设备 dev 之间传送 b[0..nr-1] 这 nr 个数据块
+// buffer 是物理地址（内核中线性地址与物理地址相同），nr 个块在内存中是连续的，
+// 调用者要保证它们位于同一页面中，并且在传送期间页面不会被释放
+// 请求项的 bh 为空，waiting 指向当前进程。设备上连续的块合并成一个请求项
+// （软驱一次只能传送一个块，不合并）。全部请求项提交后再等待它们完成，
+// 完成时 end_request() 唤醒本进程，但不释放请求项，结果由这里取得后再释放
+// 返回：0 - 成功；-EIO - 出错
+int ll_rw_direct(int rw, int dev, int *b, int nr, char *buffer)
+{
+	struct request *req[4], *tmp;
+	struct blk_dev_struct *bdev;
+	unsigned int major;
+	int start[4];
+	int i, n, k, error = 0;
+
+	if ((major = MAJOR(dev)) >= NR_BLK_DEV ||
+		!(bdev = blk_dev + major)->request_fn)
+	{
+		printk("Trying to read nonexistent block-device\n\r");
+		return -EIO;
+	}
+	if (rw != READ && rw != WRITE)
+		panic("Bad block dev command, must be R/W");
+	if (nr <= 0 || nr > 4)
+		panic("ll_rw_direct: bad number of blocks");
+
+	// 先算出需要几个请求项，start[] 记录每个请求项的第一个块
+	for (n = 0, i = 0; i < nr; i++)
+		if (!n || major == 2 || b[i] != b[i - 1] + 1)
+			start[n++] = i;
+
+	// 一次取得全部请求项，不够则等待，这样等待时本进程没有未完成的请求
+	// 与 make_request() 一样，写操作只能使用前 2/3 的请求项
+repeat:
+	tmp = request + ((rw == READ) ? NR_REQUEST : (NR_REQUEST * 2) / 3);
+	for (k = 0; k < n && --tmp >= request;)
+		if (tmp->dev < 0)
+			req[k++] = tmp;
+	if (k < n)
+	{
+		blk_stat.request_wait++;
+		sleep_on(&wait_for_request);
+		goto repeat;
+	}
+
+	for (k = 0; k < n; k++)
+	{
+		i = start[k];
+		req[k]->dev = dev;
+		req[k]->cmd = rw;
+		req[k]->errors = 0;
+		req[k]->sector = b[i] << 1;
+		req[k]->nr_sectors = (((k + 1 < n) ? start[k + 1] : nr) - i) << 1;
+		req[k]->buffer = buffer + i * BLOCK_SIZE;
+		req[k]->waiting = current;
+		req[k]->bh = NULL;
+		req[k]->next = NULL;
+	}
+	for (k = 0; k < n; k++)
+		add_request(bdev, req[k]);
+
+	// 等待全部请求项完成，每个请求项完成时都会把 waiting 置空并唤醒本进程
+	// 关中断，以免在检查和睡眠之间丢失唤醒
+	cli();
+	for (k = 0; k < n; k++)
+		while (req[k]->waiting)
+		{
+			current->state = TASK_UNINTERRUPTIBLE;
+			schedule();
+		}
+	sti();
+
+	// 取得结果并释放请求项
+	for (k = 0; k < n; k++)
+	{
+		if (req[k]->errors)
+			error = -EIO;
+		req[k]->dev = -1;
+	}
+	wake_up(&wait_for_request);
+	return error;
+}
+
+// 取主设备 major 请求队列中的请求项数（包括正在处理的当前请求项）
+int blk_queue_depth(int major)
+{
+	struct request *req;
+	int n = 0;
+
+	if (major < 0 || major >= NR_BLK_DEV)
+		return 0;
+	cli();
+	for (req = blk_dev[major].current_request; req; req = req->next)
+		n++;
+	sti();
+	return n;
+}
+
 // 块设备初始化函数，由初始化程序 main.c 调用
 // 初始化请求数组，将所有请求项置为空闲项(dev = -1)，有 32 项(NR_REQUEST = 32)
 void blk_dev_init(void)
@@ -0,0 +1,104 @@
+/*
+ *  linux/kernel/bootlog.c
+ */
+
+// 启动过程的时间记录，见 include/linux/bootlog.h
+// 实模式阶段只有 BIOS 时钟滴答数可用；进入保护模式后用时间戳计数器（TSC）计时，
+// TSC 的频率在读出时用开中断后的滴答数换算。CPU 没有 TSC 时只能用滴答数，开中断之前的各阶段都记为 0
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/trace.h>
+#include <linux/bootlog.h>
+#include <asm/system.h>
+
+const char *boot_bios_name[NR_BOOT_BIOS] = {"bootsect", "system loaded", "setup", "protected mode"};
+long boot_bios_ms[NR_BOOT_BIOS] = {-1, -1, -1, -1};
+
+struct boot_stamp boot_log[NR_BOOT_STAMP];
+int nr_boot_stamps = 0;
+
+static int boot_tsc = 0;
+static int boot_done = 0;
+
+// 复制实模式阶段的记录，并记下 main() 开始的时间。由 main() 最先调用，此时还是关中断的
+void boot_log_init(void)
+{
+	unsigned long *t = (unsigned long *)BOOT_LOG_ADDR;
+	int i;
+
+	// 滴答数不递增，或者相差一个小时以上（跨过了午夜）的记录不可信
+	if (*(unsigned short *)(BOOT_LOG_ADDR + 16) == BOOT_LOG_MAGIC)
+	{
+		for (i = 1; i < NR_BOOT_BIOS; i++)
+			if (t[i] < t[i - 1] || t[i] - t[0] > 65536)
+				break;
+		if (i == NR_BOOT_BIOS)
+			for (i = 0; i < NR_BOOT_BIOS; i++)
+				boot_bios_ms[i] = (t[i] - t[0]) * 54925 / 1000; // 每个 BIOS 滴答 54.925 毫秒
+	}
+	boot_tsc = has_tsc();
+	boot_stamp("main");
+}
+
+// 记录一个启动阶段结束的时间，name 必须是常量字符串
+void boot_stamp(const char *name)
+{
+	struct boot_stamp *s;
+	unsigned long flags;
+
+	if (boot_done || nr_boot_stamps >= NR_BOOT_STAMP)
+		return;
+	save_flags(flags);
+	cli();
+	s = boot_log + nr_boot_stamps++;
+	s->name = name;
+	s->tsc = 0;
+	if (boot_tsc)
+		__asm__ __volatile__("rdtsc"
+							 : "=A"(s->tsc));
+	s->jiffies = jiffies;
+	s->pid = current->pid;
+	restore_flags(flags);
+}
+
+// 记录最后一项并结束启动时间记录。由 tty_read() 在第一次从终端读入时调用
+void boot_log_done(const char *name)
+{
+	if (boot_done)
+		return;
+	boot_stamp(name);
+	boot_done = 1;
+}
+
+// 计算第 i 项记录距引导开始（没有实模式记录时距 main() 开始）的毫秒数
+// TSC 的频率用第一项开中断后的记录到现在的 TSC 差和滴答数差换算，两者都右移 shift 位以便用 32 位除法
+// 返回：毫秒数，还无法换算时返回 -1
+long boot_ms(int i)
+{
+	struct boot_stamp *ref;
+	unsigned long long now, total;
+	unsigned long per_tick, delta, j;
+	long base = boot_bios_ms[NR_BOOT_BIOS - 1];
+	int shift = 0;
+
+	if (base < 0)
+		base = 0;
+	if (!boot_tsc)
+		return base + boot_log[i].jiffies * (1000 / HZ);
+	for (ref = boot_log; ref < boot_log + nr_boot_stamps; ref++)
+		if (ref->jiffies)
+			break;
+	if (ref == boot_log + nr_boot_stamps || !(j = jiffies - ref->jiffies))
+		return -1;
+	__asm__ __volatile__("rdtsc"
+						 : "=A"(now));
+	for (total = now - boot_log[0].tsc; total >> 32; total >>= 1)
+		shift++;
+	per_tick = (now - ref->tsc) >> shift;
+	per_tick /= j;
+	if (!per_tick)
+		return -1;
+	delta = (boot_log[i].tsc - boot_log[0].tsc) >> shift;
+	return base + delta / per_tick * (1000 / HZ) + delta % per_tick * (1000 / HZ) / per_tick;
+}
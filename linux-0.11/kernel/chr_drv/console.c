@@ -69,10 +69,13 @@ static unsigned long video_num_lines; /* Number of test lines		*/
 // 初始显示页面
 static unsigned char video_page; /* Initial video page		*/
 
-// 显示内存起始地址
+// 显示卡显示内存的起始地址，显示控制器中的屏幕起始地址和光标位置都是相对于它的
+static unsigned long video_mem_base;
+
+// 显示内存起始地址（当前控制台所用区域的起始地址）
 static unsigned long video_mem_start; /* Start of video RAM		*/
 
-// 显示内存结束(末端)地址
+// 显示内存结束(末端)地址（当前控制台所用区域的末端地址）
 static unsigned long video_mem_end; /* End of video RAM (sort of)	*/
 
 // 显示控制索引寄存器端口
@@ -95,6 +98,9 @@ static unsigned long scr_end; /* Used for EGA/VGA fast scroll	*/
 // 当前光标对应的显示内存位置
 static unsigned long pos;
 
+// 卷屏后 origin 已经改变但还没有写入显示控制器，在 con_write() 结束时一并写入
+static int origin_dirty = 0;
+
 // 当前光标位置
 static unsigned long x, y;
 
@@ -114,6 +120,33 @@ static unsigned long ques = 0;
 // 字符属性(黑底白字)
 static unsigned char attr = 0x07;
 
+// 虚拟控制台
+// 显示内存被平分给各个控制台，每个控制台的屏幕内容和卷屏都在自己的区域中进行
+// 切换控制台时只需把显示控制器的屏幕起始地址改为该控制台的 origin，不需要复制屏幕内容
+// 上面从 video_mem_start 开始的这些变量是控制台 currcons 的状态，其它控制台的状态保存在 vc_cons[] 中，
+// con_write() 写另一个控制台时由 select_console() 交换
+static struct vc_state
+{
+	unsigned long mem_start, mem_end;
+	unsigned long origin, scr_end, pos;
+	unsigned long x, y, top, bottom;
+	unsigned long state, npar, par[NPAR], ques;
+	unsigned char attr;
+	int saved_x, saved_y;
+} vc_cons[NR_CONSOLES];
+
+// 实际使用的控制台数，由显示内存的大小决定
+static int nr_consoles = 1;
+
+// 当前变量中是哪个控制台的状态
+static int currcons = 0;
+
+// 正在显示的控制台，键盘输入也送往该控制台的读队列(keyboard.S)
+int fg_console = 0;
+
+// tty 缓冲队列地址表，在 tty_io.c 中。前两项是键盘中断处理程序使用的控制台读、写队列
+extern struct tty_queue *table_list[];
+
 // 系统蜂鸣函数
 static void sysbeep(void);
 
@@ -137,21 +170,28 @@ static inline void gotoxy(unsigned int new_x, unsigned int new_y)
 	pos = origin + y * video_size_row + (x << 1);
 }
 
-// 设置滚屏起始显示内存地址
+// 把显示内存地址 addr 写入显示控制器的一对寄存器 reg 和 reg+1
+// reg 为 12 时是屏幕起始地址，为 14 时是光标位置
+static inline void set_crtc(int reg, unsigned long addr)
+{
+	// 首先选择显示控制数据寄存器 reg，然后写入地址高字节
+	// 向右移动 9 位，表示向右移动 8 位，再除以2(2 字节代表屏幕上1 字符)
+	// 是相对于显示卡显示内存的起始地址的
+	outb_p(reg, video_port_reg);
+	outb_p(0xff & ((addr - video_mem_base) >> 9), video_port_val);
+
+	// 再选择显示控制数据寄存器 reg+1，然后写入地址低字节。向右移动 1 位表示除以 2
+	outb_p(reg + 1, video_port_reg);
+	outb_p(0xff & ((addr - video_mem_base) >> 1), video_port_val);
+}
+
+// 设置滚屏起始显示内存地址，当前控制台没有在显示时不用设置
 static inline void set_origin(void)
 {
 	// 关中断
 	cli();
-
-	// 首先选择显示控制数据寄存器 r12，然后写入卷屏起始地址高字节
-	// 向右移动 9 位，表示向右移动 8 位，再除以2(2 字节代表屏幕上1 字符)
-	// 是相对于默认显示内存操作的
-	outb_p(12, video_port_reg);
-	outb_p(0xff & ((origin - video_mem_start) >> 9), video_port_val);
-
-	// 再选择显示控制数据寄存器r13，然后写入卷屏起始地址底字节。向右移动 1 位表示除以 2
-	outb_p(13, video_port_reg);
-	outb_p(0xff & ((origin - video_mem_start) >> 1), video_port_val);
+	if (currcons == fg_console)
+		set_crtc(12, origin);
 
 	// 开中断
 	sti();
@@ -211,8 +251,9 @@ static void scrup(void)
 						"c"(video_num_columns),
 						"D"(scr_end - video_size_row));
 			}
-			// 向显示控制器中写入新的屏幕内容对应的内存起始位置值
-			set_origin();
+			// 新的屏幕内容对应的内存起始位置值在 con_write() 结束时才写入显示控制器，
+			// 这样连续卷动多行时只需要写一次端口
+			origin_dirty = 1;
 		}
 		else
 		{
@@ -461,20 +502,13 @@ void csi_m(void)
 }
 
 // 根据设置显示光标
-// 根据显示内存光标对应位置 pos，设置显示控制器光标的显示位置
+// 根据显示内存光标对应位置 pos，设置显示控制器光标(r14、r15)的显示位置，当前控制台没有在显示时不用设置
 static inline void set_cursor(void)
 {
 	// 关中断
 	cli();
-
-	// 首先使用索引寄存器端口选择显示控制数据寄存器 r14(光标当前显示位置高字节)
-	// 然后写入光标当前位置高字节(向右移动 9 位表示高字节移到低字节再除以 2)，是相对于默认显示内存操作的
-	outb_p(14, video_port_reg);
-	outb_p(0xff & ((pos - video_mem_start) >> 9), video_port_val);
-
-	// 再使用索引寄存器选择 r15，并将光标当前位置低字节写入其中
-	outb_p(15, video_port_reg);
-	outb_p(0xff & ((pos - video_mem_start) >> 1), video_port_val);
+	if (currcons == fg_console)
+		set_crtc(14, pos);
 
 	// 开中断
 	sti();
@@ -673,12 +707,112 @@ static void restore_cur(void)
 	gotoxy(saved_x, saved_y);
 }
 
+// 把当前变量中的控制台状态保存到 vc 中
+static void save_console(struct vc_state *vc)
+{
+	int i;
+
+	vc->mem_start = video_mem_start;
+	vc->mem_end = video_mem_end;
+	vc->origin = origin;
+	vc->scr_end = scr_end;
+	vc->pos = pos;
+	vc->x = x;
+	vc->y = y;
+	vc->top = top;
+	vc->bottom = bottom;
+	vc->state = state;
+	vc->npar = npar;
+	for (i = 0; i < NPAR; i++)
+		vc->par[i] = par[i];
+	vc->ques = ques;
+	vc->attr = attr;
+	vc->saved_x = saved_x;
+	vc->saved_y = saved_y;
+}
+
+// 从 vc 中装入控制台状态
+static void load_console(struct vc_state *vc)
+{
+	int i;
+
+	video_mem_start = vc->mem_start;
+	video_mem_end = vc->mem_end;
+	origin = vc->origin;
+	scr_end = vc->scr_end;
+	pos = vc->pos;
+	x = vc->x;
+	y = vc->y;
+	top = vc->top;
+	bottom = vc->bottom;
+	state = vc->state;
+	npar = vc->npar;
+	for (i = 0; i < NPAR; i++)
+		par[i] = vc->par[i];
+	ques = vc->ques;
+	attr = vc->attr;
+	saved_x = vc->saved_x;
+	saved_y = vc->saved_y;
+}
+
+// 把控制台 nr 的状态装入上面的变量中，原来的控制台 currcons 的状态保存到 vc_cons[] 中
+// 交换期间关中断，这样键盘中断中的 change_console() 看到的各控制台状态总是完整的
+static void select_console(int nr)
+{
+	if (nr == currcons)
+		return;
+	cli();
+	save_console(vc_cons + currcons);
+	load_console(vc_cons + nr);
+	currcons = nr;
+	sti();
+}
+
+// 切换显示的控制台，在键盘中断中按下 Alt+F1..Fn 时调用
+// 只需要改变显示控制器的屏幕起始地址和光标位置，并让键盘输入送往该控制台的读队列
+void change_console(int nr)
+{
+	unsigned long org, cur;
+
+	if (nr < 0 || nr >= nr_consoles || nr == fg_console)
+		return;
+	cli();
+	fg_console = nr;
+	table_list[0] = &tty_table[CON_TTY(nr)].read_q;
+	table_list[1] = &tty_table[CON_TTY(nr)].write_q;
+	if (nr == currcons)
+	{
+		org = origin;
+		cur = pos;
+	}
+	else
+	{
+		org = vc_cons[nr].origin;
+		cur = vc_cons[nr].pos;
+	}
+	set_crtc(12, org);
+	set_crtc(14, cur);
+	sti();
+}
+
 // 控制台写函数
 // 从终端对应的 tty 写缓冲队列中取字符，并显示在屏幕上
+// 先换入该终端对应的控制台的状态，结束时再换回原来的控制台
+// 这样键盘中断回显到另一个控制台时，不会破坏被中断的 con_write() 正在使用的状态
 void con_write(struct tty_struct *tty)
 {
-	int nr;
+	int nr, cons, oldcons = currcons;
 	char c;
+	unsigned short a;
+
+	// 没有对应显示内存区域的控制台，丢弃输出
+	cons = TTY_CON(tty - tty_table);
+	if (cons >= nr_consoles)
+	{
+		tty->write_q.tail = tty->write_q.head;
+		return;
+	}
+	select_console(cons);
 
 	// 首先取得写缓冲队列中现有字符数 nr，然后针对每个字符进行处理
 	nr = CHARS(tty->write_q);
@@ -707,13 +841,23 @@ void con_write(struct tty_struct *tty)
 					lf();
 				}
 
-				// 将字符 c 写到显示内存中 pos 处，并将光标右移 1 列
-				// 同时也将 pos 对应地移动 2 个字节
-				__asm__("movb attr,%%ah\n\t"
-						"movw %%ax,%1\n\t" ::"a"(c),
-						"m"(*(short *)pos));
-				pos += 2;
-				x++;
+				// 将字符 c 写到显示内存中 pos 处，并将光标右移 1 列，同时也将 pos 对应地移动 2 个字节
+				// 写队列中紧接着的可显示字符也在这里成批写入，直到行末或遇到其它字符，
+				// 不再逐个字符经过状态机
+				a = attr << 8;
+				for (;;)
+				{
+					*(unsigned short *)pos = a | (unsigned char)c;
+					pos += 2;
+					x++;
+					if (!nr || x >= video_num_columns)
+						break;
+					c = tty->write_q.buf[tty->write_q.tail];
+					if (c <= 31 || c >= 127)
+						break;
+					INC(tty->write_q.tail);
+					nr--;
+				}
 			}
 			// 如果字符 c 是转义字符 ESC，则转换状态state 到 1
 			else if (c == 27)
@@ -977,8 +1121,14 @@ void con_write(struct tty_struct *tty)
 		}
 	}
 
-	// 最后根据上面设置的光标位置，向显示控制器发送光标显示位置
+	// 最后向显示控制器写入卷屏后的屏幕起始位置（如果卷过屏）和光标显示位置，每次调用只写一次
+	if (origin_dirty)
+	{
+		set_origin();
+		origin_dirty = 0;
+	}
 	set_cursor();
+	select_console(oldcons);
 }
 
 // void con_init(void);
@@ -991,6 +1141,8 @@ void con_init(void)
 	register unsigned char a;
 	char *display_desc = "????";
 	char *display_ptr;
+	unsigned long size;
+	int i;
 
 	// 显示器显示字符列数
 	video_num_columns = ORIG_VIDEO_COLS;
@@ -1072,8 +1224,8 @@ void con_init(void)
 			// 设置显示类型(EGA 彩色)
 			video_type = VIDEO_TYPE_EGAC;
 
-			// 设置显示内存末端地址
-			video_mem_end = 0xbc000;
+			// 设置显示内存末端地址，彩色文本模式下 EGA/VGA 的显示内存窗口有 32KB
+			video_mem_end = 0xc0000;
 
 			// 设置显示描述字符串
 			display_desc = "EGAc";
@@ -1108,22 +1260,58 @@ void con_init(void)
 		display_ptr++;
 	}
 
-	// 初始化用于滚屏的变量(主要用于EGA/VGA)
+	// 划分虚拟控制台：EGA/VGA 的显示内存可以放下几屏就使用几个控制台（最多 NR_CONSOLES 个）
+	// 每个控制台的区域是整数行，多出一屏的部分用于快速卷屏
+	// MDA、CGA 的显示内存只有一两屏，只使用一个控制台
+	video_mem_base = video_mem_start;
+	if (video_type == VIDEO_TYPE_EGAC || video_type == VIDEO_TYPE_EGAM)
+	{
+		nr_consoles = (video_mem_end - video_mem_base) / (video_num_lines * video_size_row);
+		if (nr_consoles > NR_CONSOLES)
+			nr_consoles = NR_CONSOLES;
+	}
+	size = (video_mem_end - video_mem_base) / nr_consoles / video_size_row * video_size_row;
 
-	// 滚屏起始显示内存地址
-	origin = video_mem_start;
+	// 从最后一个控制台开始初始化各控制台的状态，控制台 0 保留引导时的屏幕内容和光标位置
+	// 其它控制台清屏，它们的终端使用与控制台 0 相同的 termios 设置
+	for (i = nr_consoles - 1; i >= 0; i--)
+	{
+		// 本控制台的显示内存区域
+		video_mem_start = video_mem_base + i * size;
+		video_mem_end = video_mem_start + size;
 
-	// 滚屏结束内存地址
-	scr_end = video_mem_start + video_num_lines * video_size_row;
+		// 初始化用于滚屏的变量(主要用于EGA/VGA)
 
-	// 最顶行号
-	top = 0;
+		// 滚屏起始显示内存地址
+		origin = video_mem_start;
 
-	// 最底行号
-	bottom = video_num_lines;
+		// 滚屏结束内存地址
+		scr_end = video_mem_start + video_num_lines * video_size_row;
 
-	// 初始化光标位置 x, y 和对应的内存位置 pos
-	gotoxy(ORIG_X, ORIG_Y);
+		// 最顶行号
+		top = 0;
+
+		// 最底行号
+		bottom = video_num_lines;
+		attr = 0x07;
+		state = 0;
+
+		if (i)
+		{
+			pos = origin;
+			csi_J(2);
+			gotoxy(0, 0);
+			save_console(vc_cons + i);
+		}
+		else
+			// 初始化光标位置 x, y 和对应的内存位置 pos
+			gotoxy(ORIG_X, ORIG_Y);
+	}
+	for (i = 1; i < NR_CONSOLES; i++)
+	{
+		tty_table[CON_TTY(i)].termios = tty_table[0].termios;
+		tty_table[CON_TTY(i)].write = con_write;
+	}
 
 	// 设置键盘中断陷阱门
 	set_trap_gate(0x21, &keyboard_interrupt);
@@ -0,0 +1,208 @@
+/*
+ *  linux/kernel/chr_drv/pty.c
+ */
+
+// 伪终端（pty）驱动
+// 每个伪终端由一对设备组成：从端（/dev/ttypN，主设备号 4，次设备号 PTY_SLAVE+N）是一个普通的终端，
+// 使用 tty_table 中的 tty 结构，与控制台、串口终端一样经过 copy_to_cooked() 的行规程处理和 tty_ioctl() 的设置；
+// 主端（/dev/ptypN，主设备号 4，次设备号 PTY_MASTER+N）代替终端硬件：
+// 写主端的字符直接放入从端的读队列 read_q，相当于终端键盘输入；
+// 从端写出（包括回显）的字符留在从端的写队列 write_q 中，由读主端的进程取走，相当于终端屏幕输出
+// 主端打开时分配该伪终端并初始化从端的 tty 结构，同一时刻只能被打开一次，其它进程打开时返回 -EIO，
+// 因此需要伪终端的程序依次尝试打开 /dev/ptyp0、/dev/ptyp1 …，直到找到空闲的一对
+// 主端最后一次关闭时挂断该伪终端：向从端的前台进程组发送 SIGHUP，以后读写从端返回 -EIO
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/poll.h>
+
+#include <linux/sched.h>
+#include <linux/tty.h>
+#include <asm/segment.h>
+#include <asm/system.h>
+
+struct pty_struct pty_table[NR_PTY];
+
+// 从端打开时使用的 termios 设置，与控制台相同
+static struct termios pty_termios = {
+	ICRNL,									 // 将输入的 CR 转换为 NL
+	OPOST | ONLCR,							 // 将输出的 NL 转 CRNL
+	B38400 | CS8,							 // 控制模式标志
+	ISIG | ICANON | ECHO | ECHOCTL | ECHOKE, // 本地模式标志
+	0,										 // 行规程 0
+	INIT_C_CC};								 // 控制字符数组
+
+// 把用户缓冲区 buf 中最多 nr 个字符成块复制到队列 queue 中，每次复制缓冲区中连续的一段
+// 与 copy_queue_to_user() 相反，这里只修改队列头指针
+// 返回：复制的字符数
+static int copy_user_to_queue(struct tty_queue *queue, char *buf, int nr)
+{
+	unsigned long head, tail;
+	int chars, copied = 0;
+
+	while (nr > 0 && !FULL(*queue))
+	{
+		head = queue->head;
+		tail = queue->tail;
+		chars = ((tail > head) ? tail - 1 : (tail ? TTY_BUF_SIZE : TTY_BUF_SIZE - 1)) - head;
+		if (chars > nr)
+			chars = nr;
+		memcpy_fromfs(queue->buf + head, buf, chars);
+		queue->head = (head + chars) & (TTY_BUF_SIZE - 1);
+		buf += chars;
+		nr -= chars;
+		copied += chars;
+	}
+	return copied;
+}
+
+// 从端的写函数（tty->write），由 tty_write() 和 copy_to_cooked() 的回显调用
+// 字符已经在写队列中，只需唤醒读主端的进程；主端已关闭时丢弃输出
+void pty_write(struct tty_struct *tty)
+{
+	struct pty_struct *pty = pty_table + (tty - tty_table - PTY_SLAVE);
+
+	if (!pty->master)
+	{
+		tty->write_q.tail = tty->write_q.head;
+		return;
+	}
+	wake_up(&pty->wait);
+}
+
+// 打开伪终端设备，由 sys_open() 对主设备号为 4 的字符设备调用
+// 打开主端时分配该伪终端，并初始化从端的 tty 结构；从端只有在主端打开时才能打开
+// 参数：minor - 次设备号，不是伪终端的次设备号直接返回 0
+// 返回：0 表示成功，出错返回出错码
+int pty_open(int minor)
+{
+	struct tty_struct *tty;
+	struct pty_struct *pty;
+
+	if (IS_PTY_SLAVE(minor))
+		return pty_table[minor - PTY_SLAVE].master ? 0 : -EIO;
+	if (!IS_PTY_MASTER(minor))
+		return 0;
+	pty = pty_table + (minor - PTY_MASTER);
+	if (pty->master)
+		return -EIO;
+	pty->master = 1;
+
+	tty = tty_table + PTY_SLAVE + (minor - PTY_MASTER);
+	tty->termios = pty_termios;
+	tty->pgrp = 0;
+	tty->stopped = 0;
+	tty->write = pty_write;
+	tty->read_q.head = tty->read_q.tail = 0;
+	tty->write_q.head = tty->write_q.tail = 0;
+	tty->secondary.head = tty->secondary.tail = 0;
+	tty->secondary.data = 0;
+	return 0;
+}
+
+// 伪终端主端的最后一次关闭，由 sys_close() 调用，挂断该伪终端
+// 向从端的前台进程组发送 SIGHUP，并使以该从端为控制终端的进程不再有控制终端，
+// 这样该伪终端被重新分配之后，新的会话不会收到旧进程的信号和输入输出
+// 参数：minor - 次设备号，不是伪终端主端则不做任何处理
+void pty_close(int minor)
+{
+	struct tty_struct *tty;
+	int i, channel;
+
+	if (!IS_PTY_MASTER(minor))
+		return;
+	channel = PTY_SLAVE + (minor - PTY_MASTER);
+	tty = tty_table + channel;
+	pty_table[minor - PTY_MASTER].master = 0;
+
+	tty_intr(tty, 1 << (SIGHUP - 1));
+	tty->pgrp = 0;
+	for (i = 0; i < NR_TASKS; i++)
+		if (task[i] && task[i]->tty == channel)
+			task[i]->tty = -1;
+
+	// 丢弃未被读走的输出，并唤醒在从端上等待的进程
+	tty->write_q.tail = tty->write_q.head;
+	wake_up(&tty->write_q.proc_list);
+	wake_up(&tty->secondary.proc_list);
+}
+
+// 读伪终端主端，即取走从端的输出
+// 写队列空时睡眠，直到从端写出字符；然后把写队列中的字符成块复制给用户
+// 参数：n - 伪终端号；buf - 用户缓冲区；nr - 欲读字节数
+// 返回：已读字节数，没有读到字符而收到信号时返回 -EINTR
+int pty_master_read(unsigned n, char *buf, int nr)
+{
+	struct tty_struct *tty = tty_table + PTY_SLAVE + n;
+	struct pty_struct *pty = pty_table + n;
+	int chars;
+
+	if (nr < 0)
+		return -EINVAL;
+	if (!nr)
+		return 0;
+	cli();
+	while (!current->signal && EMPTY(tty->write_q))
+		interruptible_sleep_on(&pty->wait);
+	sti();
+	if (!(chars = copy_queue_to_user(&tty->write_q, buf, nr)))
+		return -EINTR;
+
+	// 写队列有了空间，唤醒等待写从端的进程
+	wake_up(&tty->write_q.proc_list);
+	return chars;
+}
+
+// 写伪终端主端，即作为从端的输入
+// 字符成块复制到从端的读队列中，再调用 copy_to_cooked() 做行规程处理（原始输入模式下只唤醒读进程）
+// 读队列满时睡眠，从端的读操作取走字符后会唤醒这里
+// 参数：n - 伪终端号；buf - 用户缓冲区；nr - 欲写字节数
+// 返回：已写字节数，没有写入字符而收到信号时返回 -EINTR
+int pty_master_write(unsigned n, char *buf, int nr)
+{
+	struct tty_struct *tty = tty_table + PTY_SLAVE + n;
+	char *b = buf;
+	int chars;
+
+	if (nr < 0)
+		return -EINVAL;
+	while (nr > 0)
+	{
+		// 先让读队列中已有的字符进入辅助队列，仍然满则睡眠等待
+		cli();
+		copy_to_cooked(tty);
+		while (!current->signal && FULL(tty->read_q))
+		{
+			interruptible_sleep_on(&tty->read_q.proc_list);
+			copy_to_cooked(tty);
+		}
+		sti();
+		if (current->signal)
+			break;
+		chars = copy_user_to_queue(&tty->read_q, b, nr);
+		b += chars;
+		nr -= chars;
+		cli();
+		copy_to_cooked(tty);
+		sti();
+	}
+	if (b == buf && nr > 0)
+		return -EINTR;
+	return b - buf;
+}
+
+// 取伪终端主端 n 的就绪状态，供 select()/poll() 使用
+// 从端有输出时可读，从端的读队列不满时可写；rq、wq 返回相应的等待队列
+int pty_poll(unsigned n, struct task_struct ***rq, struct task_struct ***wq)
+{
+	struct tty_struct *tty = tty_table + PTY_SLAVE + n;
+	int mask = 0;
+
+	if (!EMPTY(tty->write_q))
+		mask |= POLLIN;
+	if (!FULL(tty->read_q))
+		mask |= POLLOUT;
+	*rq = &pty_table[n].wait;
+	*wq = &tty->read_q.proc_list;
+	return mask;
+}
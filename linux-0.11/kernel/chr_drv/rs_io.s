@@ -93,10 +93,13 @@ rep_int:
 	# 若无待处理中断，则跳转至退出处理处 end
 	jne end
 
+	# 启用 FIFO 的 16550A 在位 7-6 中返回 FIFO 状态，只保留中断类型位 3-1
+	andb $0xe,%al
+
 	# 这不会发生，但是 ……
-	cmpb $6,%al
+	cmpb $12,%al
 
-	# al 值>6? 是则跳转至end（没有这种状态）
+	# al 值>12? 是则跳转至end（没有这种状态）
 	ja end
 
 	# 再取缓冲队列指针地址 -> ecx
@@ -151,8 +154,11 @@ end:
 # 写字符中断
 # 读字符中断
 # 线路状态有问题中断
+# 启用 FIFO 后还有接收超时中断（值 0xc）：接收 FIFO 中的字符数未到触发级，但已有 4 个字符时间没有新字符，
+# 按接收字符中断处理，4、5 两种值不会出现，按 modem 状态变化处理
 jmp_table:
 	.long modem_status,write_char,read_char,line_status
+	.long modem_status,modem_status,read_char
 
 # 由于 modem 状态发生变化而引发此次中断
 # 通过读 modem 状态寄存器对其进行复位操作
@@ -176,27 +182,31 @@ line_status:
 # 将接收到的字符放到读缓冲队列read_q 头指针（head）处
 # 并且让该指针前移一个字符位置
 # 若 head 指针已经到达缓冲区末端，则让其折返到缓冲区开始处
+# 只要线路状态寄存器的数据就绪位（位0）仍置位就继续读，启用 FIFO 时一次中断可以取走 FIFO 中的全部字符
 # 最后调用 C 函数 do_tty_interrupt()，也即 copy_to_cooked()
 # 把读入的字符经过一定处理，放入规范模式缓冲队列（辅助缓冲队列 secondary）中
 .align 2
 read_char:
-	# 读取字符 -> al
-	inb %dx,%al
+	# 当前串口缓冲队列指针地址 -> eax
+	movl %ecx,%eax
 
-	# 当前串口缓冲队列指针地址 -> edx
-	movl %ecx,%edx
-
-	# 缓冲队列指针表首址 - 当前串口队列指针地址 -> edx
-	subl $table_list,%edx
+	# 缓冲队列指针表首址 - 当前串口队列指针地址 -> eax
+	subl $table_list,%eax
 
 	# 差值/8，对于串口1 是 1，对于串口2 是 2
-	shrl $3,%edx
+	shrl $3,%eax
+
+	# 将串口号压入堆栈(1- 串口1，2 - 串口2)，作为以后调用 do_tty_interrupt 的参数
+	pushl %eax
 
 	# 取读缓冲队列结构地址 -> ecx
 	movl (%ecx),%ecx		# read-queue
 
 	# 取读队列中缓冲头指针 -> ebx
 	movl head(%ecx),%ebx
+1:
+	# 读取字符 -> al
+	inb %dx,%al
 
 	# 将字符放在缓冲区中头指针所指的位置
 	movb %al,buf(%ecx,%ebx)
@@ -210,16 +220,22 @@ read_char:
 	# 缓冲区头指针与尾指针比较
 	cmpl tail(%ecx),%ebx
 
-	# 若相等，表示缓冲区满，跳转到标号1 处
-	je 1f
+	# 若不等则保留该字符，否则缓冲区满，头指针退回，丢弃该字符
+	jne 2f
+	decl %ebx
+	andl $size-1,%ebx
+2:
+	# 读线路状态寄存器 0x3fd(0x2fd)，若还有接收到的字符则继续读
+	addl $5,%edx
+	inb %dx,%al
+	subl $5,%edx
+	testb $1,%al
+	jne 1b
 
 	# 保存修改过的头指针
 	movl %ebx,head(%ecx)
-1:
-	# 将串口号压入堆栈(1- 串口1，2 - 串口2)，作为参数
-	pushl %edx
 
-	# 调用 tty 中断处理 C 函数
+	# 调用 tty 中断处理 C 函数，整批字符只调用一次
 	call do_tty_interrupt
 
 	# 丢弃入栈参数，并返回
@@ -230,10 +246,18 @@ read_char:
 # 说明对应串行终端的写字符缓冲队列中有字符需要发送
 # 于是计算出写队列中当前所含字符数
 # 若字符数已小于 256 个则唤醒等待写操作进程
-# 然后从写缓冲队列尾部取出一个字符发送，并调整和保存尾指针
+# 然后从写缓冲队列尾部取出字符发送，并调整和保存尾指针
+# 发送保持寄存器空时 16550A 的发送 FIFO 也已经空了，因此一次可以送出 rs_fifo_size[] 个字符（16 或 1）
 # 如果写缓冲队列已空，则跳转到 write_buffer_empty，处理写缓冲队列空的情况
 .align 2
 write_char:
+	# 本次最多送出的字符数 -> esi，esi 不在 rs_int 保存的寄存器之列，需自己保存
+	pushl %esi
+	movl %ecx,%esi
+	subl $table_list,%esi
+	shrl $3,%esi
+	movl rs_fifo_size(,%esi,4),%esi
+
 	# 取写缓冲队列结构地址 -> ecx
 	movl 4(%ecx),%ecx		# write-queue
 
@@ -247,7 +271,7 @@ write_char:
 	andl $size-1,%ebx		# nr chars in queue
 
 	# 如果头指针 = 尾指针，说明写队列无字符，跳转处理
-	je write_buffer_empty
+	je 3f
 
 	# 队列中字符数超过 256 个？
 	cmpl $startup,%ebx
@@ -256,21 +280,11 @@ write_char:
 	ja 1f
 
 	# 唤醒等待的进程
-	# 取等待该队列的进程的指针，并判断是否为空
-	movl proc_list(%ecx),%ebx	# wake up sleeping process
-
-	# 有等待的进程吗？
-	testl %ebx,%ebx			# is there any?
-
-	# 是空的，则向前跳转到标号1 处
-	je 1f
-
-	# 否则将进程置为可运行状态(唤醒进程)。。
-	movl $0,(%ebx)
+	call wake_write_q
 1:
 	# 取尾指针
 	movl tail(%ecx),%ebx
-
+2:
 	# 从缓冲中尾指针处取一字符 -> al
 	movb buf(%ecx,%ebx),%al
 
@@ -283,15 +297,23 @@ write_char:
 	# 尾指针若到缓冲区末端，则折回
 	andl $size-1,%ebx
 
-	# 保存已修改过的尾指针
-	movl %ebx,tail(%ecx)
-
-	# 尾指针与头指针比较
+	# 尾指针与头指针比较，若相等，表示队列已空，则跳转
 	cmpl head(%ecx),%ebx
+	je 4f
 
-	# 若相等，表示队列已空，则跳转
-	je write_buffer_empty
+	# 还没有送满 FIFO 则继续送下一个字符
+	decl %esi
+	jne 2b
+
+	# 保存已修改过的尾指针
+	movl %ebx,tail(%ecx)
+	popl %esi
 	ret
+4:
+	movl %ebx,tail(%ecx)
+3:
+	popl %esi
+	jmp write_buffer_empty
 
 # 处理写缓冲队列 write_q 已空的情况，若有等待写该串行终端的进程则唤醒之
 # 然后屏蔽发送保持寄存器空中断，不让发送保持寄存器空时产生中断
@@ -299,18 +321,8 @@ write_char:
 write_buffer_empty:
 
 	# 唤醒等待的进程
-	# 取等待该队列的进程的指针，并判断是否为空
-	movl proc_list(%ecx),%ebx	# wake up sleeping process
-
-	# 有等待的进程吗？
-	testl %ebx,%ebx			# is there any?
+	call wake_write_q
 
-	# 无，则向前跳转到标号1 处
-	je 1f
-
-	# 否则将进程置为可运行状态(唤醒进程)
-	movl $0,(%ebx)
-1:
 	# 指向端口 0x3f9(0x2f9)
 	incl %edx
 
@@ -328,3 +340,18 @@ write_buffer_empty:
 	# 写入 0x3f9(0x2f9)
 	outb %al,%dx
 	ret
+
+# 唤醒等待写队列（ecx 指向写队列）的进程
+# 通过 wake_up() 唤醒，这样在 select() 中等待该队列的进程也会被唤醒
+# wake_up() 是 C 函数，会改变 eax、ecx、edx，因此先保存 ecx 和 edx
+.align 2
+wake_write_q:
+	pushl %edx
+	pushl %ecx
+	leal proc_list(%ecx),%ebx
+	pushl %ebx
+	call wake_up
+	addl $4,%esp
+	popl %ecx
+	popl %edx
+	ret
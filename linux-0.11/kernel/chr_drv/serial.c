@@ -18,6 +18,10 @@
 // 当写队列中含有 WAKEUP_CHARS 个字符时，就开始发送
 #define WAKEUP_CHARS (TTY_BUF_SIZE / 4)
 
+// 各串口每次发送保持寄存器空中断时最多送出的字符数，由 rs_io.s 中的 write_char 使用
+// 检测到 16550A 时为其发送 FIFO 的长度 16，否则为 1。下标是 tty 号，0 号是控制台不使用
+unsigned long rs_fifo_size[3] = {0, 1, 1};
+
 // 串行口 1 的中断处理程序
 extern void rs1_interrupt(void);
 
@@ -26,8 +30,11 @@ extern void rs2_interrupt(void);
 
 // 初始化串行端口
 // port: 串口1 - 0x3F8，串口2 - 0x2F8
-static void init(int port)
+// 返回：每次发送中断可以送出的字符数
+static int init(int port)
 {
+	int fifo;
+
 	// 设置线路控制寄存器的 DLAB 位(位7)
 	outb_p(0x80, port + 3); /* set DLAB of line control reg */
 
@@ -46,8 +53,21 @@ static void init(int port)
 	// 除了写(写保持空)以外，允许所有中断源中断
 	outb_p(0x0d, port + 1); /* enable all intrs but writes */
 
+	// 检测 16550A：向 FIFO 控制寄存器写入 0x07（允许并清空收发 FIFO），
+	// 只有 FIFO 可用的 16550A 会在中断标识寄存器的位 7-6 中返回 11
+	// 8250/16450 没有 FIFO，早期 16550 的 FIFO 有缺陷，都不使用 FIFO，触发级由 change_speed() 设置
+	outb_p(0x07, port + 2);
+	if ((inb_p(port + 2) & 0xc0) == 0xc0)
+		fifo = 16;
+	else
+	{
+		outb_p(0x00, port + 2);
+		fifo = 1;
+	}
+
 	// 读数据口，以进行复位操作(?)
 	(void)inb(port); /* read data port to reset things (?) */
+	return fifo;
 }
 
 // 初始化串行中断程序和串行接口
@@ -59,11 +79,13 @@ void rs_init(void)
 	// 设置串行口2 的中断门向量(硬件 IRQ3 信号)
 	set_intr_gate(0x23, rs2_interrupt);
 
-	// 初始化串行口1(.data 是端口号)
-	init(tty_table[1].read_q.data);
+	// 初始化串行口1(.data 是端口号)，再按 termios 中的设置设置波特率和 FIFO 触发级
+	rs_fifo_size[1] = init(tty_table[1].read_q.data);
+	change_speed(tty_table + 1);
 
 	// 初始化串行口2
-	init(tty_table[2].read_q.data);
+	rs_fifo_size[2] = init(tty_table[2].read_q.data);
+	change_speed(tty_table + 2);
 
 	// 允许主 8259A 芯片的 IRQ3，IRQ4 中断信号请求
 	outb(inb_p(0x21) & 0xE7, 0x21);
@@ -22,6 +22,7 @@
 
 #include <linux/sched.h>
 #include <linux/tty.h>
+#include <linux/bootlog.h>
 #include <asm/segment.h>
 #include <asm/system.h>
 
@@ -54,7 +55,8 @@
 // tty 数据结构的 tty_table 数组
 // 其中包含三个初始化项数据
 // 分别对应控制台、串口终端1 和 串口终端2 的初始化数据
-struct tty_struct tty_table[] = {
+// 其后是伪终端的从端，在主端打开时由 pty_open() 初始化
+struct tty_struct tty_table[NR_TTY] = {
 	{
 		{ICRNL,									  // 将输入的 CR 转换为 NL
 		 OPOST | ONLCR,							  // 将输出的 NL 转 CRNL
@@ -178,6 +180,38 @@ static void sleep_if_full(struct tty_queue *queue)
 	sti();
 }
 
+// 原始输入模式下，若读队列和辅助队列都空则让进程进入可中断的睡眠状态
+// 原始模式下字符留在读队列中，copy_to_cooked() 仍然唤醒等待辅助队列的进程
+static void sleep_if_raw_empty(struct tty_struct *tty)
+{
+	cli();
+	while (!current->signal && EMPTY(tty->read_q) && EMPTY(tty->secondary) && RAW_INPUT(tty))
+		interruptible_sleep_on(&tty->secondary.proc_list);
+	sti();
+}
+
+// 把队列 queue 中最多 nr 个字符成块复制到用户缓冲区 buf 中，每次复制缓冲区中连续的一段
+// 这里只修改队列尾指针，而中断处理程序只修改头指针，因此复制时不必关中断
+// 返回：复制的字符数
+int copy_queue_to_user(struct tty_queue *queue, char *buf, int nr)
+{
+	unsigned long head, tail;
+	int chars, copied = 0;
+
+	while (nr > 0 && (head = queue->head) != (tail = queue->tail))
+	{
+		chars = ((head > tail) ? head : TTY_BUF_SIZE) - tail;
+		if (chars > nr)
+			chars = nr;
+		memcpy_tofs(buf, queue->buf + tail, chars);
+		queue->tail = (tail + chars) & (TTY_BUF_SIZE - 1);
+		buf += chars;
+		nr -= chars;
+		copied += chars;
+	}
+	return copied;
+}
+
 // 等待按键
 // 如果控制台的读队列缓冲区空，则让进程进入可中断的睡眠状态
 void wait_for_keypress(void)
@@ -192,6 +226,13 @@ void copy_to_cooked(struct tty_struct *tty)
 {
 	signed char c;
 
+	// 原始输入模式下不需要任何处理，字符留在读队列中由 tty_read() 直接取走，这里只唤醒读终端的进程
+	if (RAW_INPUT(tty))
+	{
+		wake_up(&tty->secondary.proc_list);
+		return;
+	}
+
 	// 如果 tty 的读队列缓冲区不空，并且辅助队列缓冲区为空，则循环执行下列代码
 	while (!EMPTY(tty->read_q) && !FULL(tty->secondary))
 	{
@@ -348,6 +389,9 @@ void copy_to_cooked(struct tty_struct *tty)
 	}
 	// 唤醒等待该辅助缓冲队列的进程（如果有的话）
 	wake_up(&tty->secondary.proc_list);
+
+	// 读队列中的字符已被取走，唤醒等待写伪终端主端的进程
+	wake_up(&tty->read_q.proc_list);
 }
 
 // tty 读函数，从终端辅助缓冲队列中读取指定数量的字符，放到用户指定的缓冲区中
@@ -360,17 +404,32 @@ int tty_read(unsigned channel, char *buf, int nr)
 {
 	struct tty_struct *tty;
 	char c, *b = buf;
-	int minimum, time, flag = 0;
+	int minimum, time, chars, flag = 0;
 	long oldalarm;
 
-	// 本版本 linux 内核的终端只有 3 个子设备，分别是 控制台(0)、串口终端1(1) 和 串口终端2(2)
-	// 所以任何大于 2 的子设备号都是非法的，读的字节数当然也不能小于 0 的
-	if (channel > 2 || nr < 0)
+	// 终端的子设备号是 控制台(0)、串口终端1(1)、串口终端2(2) 和伪终端的从端
+	// 所以任何超出 tty_table 的子设备号都是非法的，读的字节数当然也不能小于 0 的
+	if (channel >= NR_TTY || nr < 0)
 		return -1;
 
+	// 第一次从终端读入，通常是 shell 显示提示符后等待命令，启动过程到此结束
+	boot_log_done("tty_read");
+
+	// 伪终端的主端没有打开或已经关闭时，从端不能读
+	if (IS_PTY_SLAVE(channel) && !pty_table[channel - PTY_SLAVE].master)
+		return -EIO;
+
 	// tty 指针指向子设备号对应 ttb_table 表中的 tty 结构
 	tty = &tty_table[channel];
 
+	// 从原始模式切换回来后，读队列中可能还留有未经处理的字符，先把它们处理到辅助队列中
+	if (!RAW_INPUT(tty) && !EMPTY(tty->read_q))
+	{
+		cli();
+		copy_to_cooked(tty);
+		sti();
+	}
+
 	// 下面首先保存进程原定时值，然后根据控制字符 VTIME 和 VMIN 设置读字符操作的超时定时值
 	// 在非规范模式下，这两个值是超时定时值
 	// MIN 表示为了满足读操作，需要读取的最少字符数
@@ -413,39 +472,58 @@ int tty_read(unsigned channel, char *buf, int nr)
 		if (current->signal)
 			break;
 
-		// 如果辅助缓冲队列(规范模式队列)为空
-		// 或者设置了规范模式标志，并且辅助队列中字符数为0
-		// 以及辅助模式缓冲队列空闲空间>20，则进入可中断睡眠状态，返回后继续处理
-		if (EMPTY(tty->secondary) || (L_CANON(tty) &&
-									  !tty->secondary.data && LEFT(tty->secondary) > 20))
+		// 原始输入模式的快速路径：辅助队列中切换模式前留下的字符取完之后，
+		// 直接从读队列中成块复制，读队列也空时睡眠等待
+		if (RAW_INPUT(tty) && EMPTY(tty->secondary))
 		{
-			sleep_if_empty(&tty->secondary);
-			continue;
+			if (EMPTY(tty->read_q))
+			{
+				sleep_if_raw_empty(tty);
+				continue;
+			}
+			chars = copy_queue_to_user(&tty->read_q, b, nr);
+			b += chars;
+			nr -= chars;
+
+			// 读队列有了空间，唤醒等待写伪终端主端的进程
+			wake_up(&tty->read_q.proc_list);
 		}
-		// 执行以下取字符操作，需读字符数 nr 依次递减，直到 nr=0 或者辅助缓冲队列为空
-		do
+		else
 		{
-			// 取辅助缓冲队列字符 c，并且缓冲队列 secondary->tail 指针向右移动一个字符位置（tail++）
-			GETCH(tty->secondary, c);
+			// 如果辅助缓冲队列(规范模式队列)为空
+			// 或者设置了规范模式标志，并且辅助队列中字符数为0
+			// 以及辅助模式缓冲队列空闲空间>20，则进入可中断睡眠状态，返回后继续处理
+			if (EMPTY(tty->secondary) || (L_CANON(tty) &&
+										  !tty->secondary.data && LEFT(tty->secondary) > 20))
+			{
+				sleep_if_empty(&tty->secondary);
+				continue;
+			}
+			// 执行以下取字符操作，需读字符数 nr 依次递减，直到 nr=0 或者辅助缓冲队列为空
+			do
+			{
+				// 取辅助缓冲队列字符 c，并且缓冲队列 secondary->tail 指针向右移动一个字符位置（tail++）
+				GETCH(tty->secondary, c);
 
-			// 如果该字符是文件结束符 (^D) 或者是换行符 NL(10)
-			// 则把辅助缓冲队列中含有字符行数值减 1
-			if (c == EOF_CHAR(tty) || c == 10)
-				tty->secondary.data--;
+				// 如果该字符是文件结束符 (^D) 或者是换行符 NL(10)
+				// 则把辅助缓冲队列中含有字符行数值减 1
+				if (c == EOF_CHAR(tty) || c == 10)
+					tty->secondary.data--;
 
-			// 如果该字符是文件结束符(^D)并且规范模式标志置位，则返回已读字符数，并退出
-			if (c == EOF_CHAR(tty) && L_CANON(tty))
-				return (b - buf);
+				// 如果该字符是文件结束符(^D)并且规范模式标志置位，则返回已读字符数，并退出
+				if (c == EOF_CHAR(tty) && L_CANON(tty))
+					return (b - buf);
 
-			// 否则说明是原始模式（非规范模式）操作，于是将该字符直接放入用户数据段缓冲区 buf 中，
-			// 并把欲读字符数减 1。此时如果欲读字符数已为 0，则中断循环
-			else
-			{
-				put_fs_byte(c, b++);
-				if (!--nr)
-					break;
-			}
-		} while (nr > 0 && !EMPTY(tty->secondary));
+				// 否则说明是原始模式（非规范模式）操作，于是将该字符直接放入用户数据段缓冲区 buf 中，
+				// 并把欲读字符数减 1。此时如果欲读字符数已为 0，则中断循环
+				else
+				{
+					put_fs_byte(c, b++);
+					if (!--nr)
+						break;
+				}
+			} while (nr > 0 && !EMPTY(tty->secondary));
+		}
 
 		// 如果超时定时值 time 不为 0，并且规范模式标志没有置位(非规范模式)
 		if (time && !L_CANON(tty))
@@ -496,11 +574,15 @@ int tty_write(unsigned channel, char *buf, int nr)
 	struct tty_struct *tty;
 	char c, *b = buf;
 
-	// 本版本 linux 内核的终端只有 3 个子设备，分别是控制台(0)、串口终端1(1) 和 串口终端2(2)
-	// 所以任何大于 2 的子设备号都是非法的，写的字节数当然也不能小于 0 的
-	if (channel > 2 || nr < 0)
+	// 终端的子设备号是 控制台(0)、串口终端1(1)、串口终端2(2) 和伪终端的从端
+	// 所以任何超出 tty_table 的子设备号都是非法的，写的字节数当然也不能小于 0 的
+	if (channel >= NR_TTY || nr < 0)
 		return -1;
 
+	// 伪终端的主端没有打开或已经关闭时，从端不能写
+	if (IS_PTY_SLAVE(channel) && !pty_table[channel - PTY_SLAVE].master)
+		return -EIO;
+
 	// tty 指针指向子设备号对应 ttb_table 表中的 tty 结构
 	tty = channel + tty_table;
 
@@ -16,18 +16,25 @@
 #include <asm/system.h>
 
 // 这是波特率因子数组（或称为除数数组）
+// 最后两项是 CBAUDEX 置位时的 B57600、B115200
 static unsigned short quotient[] = {
 	0, 2304, 1536, 1047, 857,
 	768, 576, 384, 192, 96,
-	64, 48, 24, 12, 6, 3};
+	64, 48, 24, 12, 6, 3,
+	2, 1};
 
 // 修改传输速率
 // 参数：tty - 终端对应的 tty 数据结构
 // 在除数锁存标志 DLAB(线路控制寄存器位7) 置位情况下
 // 通过端口 0x3f8 和 0x3f9 向 UART 分别写入波特率因子低字节和高字节
-static void change_speed(struct tty_struct *tty)
+// 对有 FIFO 的 16550A，同时按速率设置接收 FIFO 的触发级：
+// 9600 及以上收到 8 个字符才中断一次，以减少高速率下的中断次数，较低速率则每个字符都中断，以免输入迟缓
+// 结束时恢复原来的中断状态：rs_init() 在开中断之前调用本函数
+void change_speed(struct tty_struct *tty)
 {
 	unsigned short port, quot;
+	unsigned long flags;
+	int i;
 
 	// 对于串口终端，其 tty 结构的读缓冲队列 data 字段存放的是串行端口号(0x3f8 或 0x2f8)
 	if (!(port = tty->read_q.data))
@@ -36,9 +43,17 @@ static void change_speed(struct tty_struct *tty)
 	// 从 tty 的 termios 结构控制模式标志集中，取得设置的波特率索引号
 	// 据此从波特率因子数组中取得对应的波特率因子值
 	// CBAUD 是控制模式标志集中波特率位屏蔽码
-	quot = quotient[tty->termios.c_cflag & CBAUD];
+	i = tty->termios.c_cflag & CBAUD;
+	if (i & CBAUDEX)
+	{
+		i = 15 + (i & ~CBAUDEX);
+		if (i == 15 || i >= sizeof(quotient) / sizeof(quotient[0]))
+			return;
+	}
+	quot = quotient[i];
 
 	// 关中断
+	save_flags(flags);
 	cli();
 
 	// 首先设置除数锁定标志 DLAB
@@ -53,8 +68,12 @@ static void change_speed(struct tty_struct *tty)
 	// 复位DLAB
 	outb(0x03, port + 3); /* reset DLAB */
 
-	// 开中断
-	sti();
+	// 设置 FIFO 控制寄存器：位0 允许 FIFO，位7-6 为接收触发级（00 - 1 个字符，10 - 8 个字符）
+	if (rs_fifo_size[tty - tty_table] > 1)
+		outb_p((quot && quot <= 12) ? 0x81 : 0x01, port + 2);
+
+	// 恢复中断状态
+	restore_flags(flags);
 }
 
 // 刷新 tty 缓冲队列
@@ -207,8 +226,14 @@ int tty_ioctl(int dev, int cmd, int arg)
 		// 否则直接从设备号中取出子设备号
 		dev = MINOR(dev);
 
-	// 子设备号可以是0(控制台终端)、1(串口1 终端)、2(串口2 终端)
+	// 对伪终端主端的操作作用于对应的从端，例如由主端设置从端的 termios 和前台进程组
+	if (IS_PTY_MASTER(dev))
+		dev = PTY_SLAVE + dev - PTY_MASTER;
+
+	// 子设备号可以是0(控制台终端)、1(串口1 终端)、2(串口2 终端) 或伪终端的从端
 	// 让 tty 指向对应子设备号的 tty 结构
+	if (dev >= NR_TTY)
+		return -ENODEV;
 	tty = dev + tty_table;
 
 	// 根据 tty 的 ioctl 命令进行分别处理
@@ -208,6 +208,15 @@ int do_exit(long code)
 	iput(current->executable);
 	current->executable = NULL;
 
+	// 撤销文件映射区，放回被映射文件的 i 节点
+	exit_mmap();
+
+	// 放弃尚未完成的异步 I/O 操作
+	exit_aio();
+
+	// 分离附加的共享内存段，段页面的映射已由前面的 free_page_tables() 撤销
+	exit_shm();
+
 	// 如果当前进程是会话头领(leader)进程并且其有控制终端，则释放该终端
 	if (current->leader && current->tty >= 0)
 		tty_table[current->tty].pgrp = 0;
@@ -248,6 +248,17 @@ int copy_process(int nr, long ebp, long edi, long esi, long gs, long none,
 	if (current->executable)
 		current->executable->i_count++;
 
+	// 子进程继承父进程的文件映射区（映射区页面已由 copy_mem() 共享），将映射文件 i 节点引用次数增 1
+	for (i = 0; i < NR_MMAP; i++)
+		if (p->mmap[i].inode)
+			p->mmap[i].inode->i_count++;
+
+	// 子进程继承父进程附加的共享内存段（段页面同样已由 copy_mem() 映射），增加各段的附加计数
+	fork_shm(p);
+
+	// 异步 I/O 操作属于父进程，子进程需要时自己重新建立上下文
+	p->aio = NULL;
+
 	// 在 GDT 中设置新任务的 TSS 和 LDT 描述符项，数据从 task 结构中取
 	// 在任务切换时，任务寄存器 tr 由 CPU 自动加载
 	set_tss_desc(gdt + (nr << 1) + FIRST_TSS_ENTRY, &(p->tss));
@@ -0,0 +1,111 @@
+/*
+ *  linux/kernel/futex.c
+ */
+
+// 用户空间同步原语的内核部分 futex_wait() / futex_wake()
+// 锁或计数器是共享内存中的一个长字，用户程序用原子指令（如 xchg、lock cmpxchg）直接操作它，
+// 没有竞争时根本不需要进入内核；只有需要等待时才调用 futex_wait()，
+// 释放者发现有等待者时调用 futex_wake() 唤醒它们
+// 等待项按长字所在的物理地址登记，因此不同进程中映射在不同线性地址上的同一共享页面对应同一个等待队列
+
+#include <errno.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <asm/segment.h>
+
+// 写页面验证，在 mm/memory.c 中
+extern void write_verify(unsigned long address);
+
+// 等待队列散列表的项数，物理地址按长字散列
+#define NR_FUTEX_HASH 32
+#define futex_hash(key) (((key) >> 2) % NR_FUTEX_HASH)
+
+// 等待项，放在等待进程的内核堆栈上，task 为空表示已被唤醒
+struct futex_q
+{
+	unsigned long key;		  // 长字的物理地址
+	struct task_struct *task; // 等待的进程
+	struct futex_q *next;
+};
+
+static struct futex_q *futex_queue[NR_FUTEX_HASH];
+
+// 取当前进程中用户地址 uaddr 处长字的物理地址，作为等待队列的键值
+// 先让页面存在并且可写：对于 fork() 后与父进程共享的私有页面，这会复制出进程自己的页面，
+// 以后的写操作不会再改变该长字的物理地址；共享内存段的页面只是恢复可写
+// 返回：物理地址，地址不是长字对齐时返回 0
+static unsigned long futex_key(unsigned long *uaddr)
+{
+	unsigned long address = (unsigned long)uaddr;
+
+	if (address & 3)
+		return 0;
+	(void)get_fs_long(uaddr);
+	address += get_base(current->ldt[2]);
+	write_verify(address);
+	return get_phys_addr(address);
+}
+
+// 系统调用 futex_wait()，若 uaddr 处的长字仍等于 val，则睡眠直到被 futex_wake() 唤醒
+// 比较和登记之间不会睡眠，内核态也不会被其它进程抢占，因此不会丢失唤醒
+// 返回：0 表示被唤醒；长字已不等于 val 时返回 -EAGAIN；被信号中断返回 -EINTR
+int sys_futex_wait(unsigned long *uaddr, unsigned long val)
+{
+	struct futex_q q, **p;
+
+	if (!(q.key = futex_key(uaddr)))
+		return -EINVAL;
+	if (get_fs_long(uaddr) != val)
+		return -EAGAIN;
+
+	// 登记在散列队列的末尾（先等待的先被唤醒），然后可中断地睡眠
+	q.task = current;
+	q.next = NULL;
+	for (p = futex_queue + futex_hash(q.key); *p; p = &(*p)->next)
+		;
+	*p = &q;
+	while (q.task && !(current->signal & ~current->blocked))
+	{
+		current->state = TASK_INTERRUPTIBLE;
+		schedule();
+	}
+	if (!q.task)
+		return 0;
+
+	// 被信号中断，从队列中取下自己的等待项
+	for (p = futex_queue + futex_hash(q.key); *p; p = &(*p)->next)
+		if (*p == &q)
+		{
+			*p = q.next;
+			break;
+		}
+	return -EINTR;
+}
+
+// 系统调用 futex_wake()，唤醒最多 nr 个在 uaddr 处长字上等待的进程
+// 返回：唤醒的进程数
+int sys_futex_wake(unsigned long *uaddr, int nr)
+{
+	struct futex_q **p, *q;
+	unsigned long key;
+	int woken = 0;
+
+	if (!(key = futex_key(uaddr)))
+		return -EINVAL;
+	for (p = futex_queue + futex_hash(key); *p && woken < nr;)
+	{
+		q = *p;
+		if (q->key != key)
+		{
+			p = &q->next;
+			continue;
+		}
+		*p = q->next;
+		q->task->state = TASK_RUNNING;
+		q->task = NULL;
+		woken++;
+	}
+	return woken;
+}
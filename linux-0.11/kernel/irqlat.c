@@ -0,0 +1,161 @@
+/*
+ *  linux/kernel/irqlat.c
+ */
+
+// 关中断时间统计
+// 只有编译时打开了 IRQ_LATENCY 选项才会编译进内核，这时 <asm/system.h> 中的 cli()/sti()/restore_flags()
+// 都调用这里的函数：从开中断状态关中断时记下时间戳和调用地址，再次开中断时计入统计表
+// 已经处于关中断状态时的 cli()（嵌套）不重新计时，中断处理程序中（由中断门关中断）的 cli()/sti() 也不计入
+// 汇编代码中的 cli/sti、iret 和任务切换恢复的标志寄存器都不经过这里，因此：
+//   - schedule() 在切换任务之前调用 irqlat_switch() 结束当前一段，关中断睡眠的代码段计到 schedule() 为止
+//   - 关中断期间 jiffies 变化了说明中间开过中断，这一段不计入
+// 时钟中断只有开中断后才能得到处理，所以超过一个滴答的代码段仍然会被如实记录
+
+#ifdef IRQ_LATENCY
+
+#include <errno.h>
+#include <sys/types.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/trace.h>
+#include <linux/irqlat.h>
+#include <asm/system.h>
+
+// 标志寄存器中的中断允许标志 IF
+#define IF_MASK 0x200
+
+struct irqlat_entry irqlat[NR_IRQLAT];
+
+// CPU 是否有时间戳计数器，-1 表示还没有检查
+static int irqlat_tsc = -1;
+
+// 当前正在计时的关中断代码段：是否在计时、开始时刻、关中断的地址和当时的滴答数
+static int irqlat_open = 0;
+static unsigned long long irqlat_start;
+static unsigned long irqlat_site;
+static unsigned long irqlat_jiffies;
+
+// 把一段时间为 t 的关中断代码段计入统计表，保持表项按最长时间从大到小排列
+static void irqlat_record(unsigned long off, unsigned long on, unsigned long long t)
+{
+	struct irqlat_entry tmp;
+	int i;
+
+	for (i = 0; i < NR_IRQLAT && irqlat[i].off_site; i++)
+		if (irqlat[i].off_site == off)
+			break;
+	if (i == NR_IRQLAT)
+	{
+		// 表满了，替换最后一项（最短的）
+		i = NR_IRQLAT - 1;
+		if (t <= irqlat[i].max)
+			return;
+		irqlat[i].off_site = 0;
+	}
+	if (!irqlat[i].off_site)
+	{
+		irqlat[i].off_site = off;
+		irqlat[i].count = 0;
+		irqlat[i].max = 0;
+		irqlat[i].total = 0;
+		irqlat[i].on_site = on;
+		irqlat[i].max_pid = current->pid;
+	}
+	irqlat[i].count++;
+	irqlat[i].total += t;
+	if (t <= irqlat[i].max)
+		return;
+	irqlat[i].max = t;
+	irqlat[i].on_site = on;
+	irqlat[i].max_pid = current->pid;
+	for (; i > 0 && irqlat[i - 1].max < irqlat[i].max; i--)
+	{
+		tmp = irqlat[i - 1];
+		irqlat[i - 1] = irqlat[i];
+		irqlat[i] = tmp;
+	}
+}
+
+// 开中断之前调用，site 是开中断的地址。调用时必须仍处于关中断状态
+static void irqlat_end(unsigned long site)
+{
+	unsigned long long t = 0;
+	unsigned long flags;
+
+	save_flags(flags);
+	if ((flags & IF_MASK) || !irqlat_open)
+	{
+		irqlat_open = 0;
+		return;
+	}
+	irqlat_open = 0;
+	if (jiffies != irqlat_jiffies)
+		return;
+	if (irqlat_tsc)
+	{
+		__asm__ __volatile__("rdtsc"
+							 : "=A"(t));
+		t -= irqlat_start;
+	}
+	irqlat_record(irqlat_site, site, t);
+}
+
+// cli()，从开中断状态关中断时开始计时
+void irqlat_cli(void)
+{
+	unsigned long flags;
+
+	save_flags(flags);
+	__cli();
+	if (!(flags & IF_MASK))
+		return;
+	if (irqlat_tsc < 0)
+		irqlat_tsc = has_tsc();
+	irqlat_open = 1;
+	irqlat_site = (unsigned long)__builtin_return_address(0);
+	irqlat_jiffies = jiffies;
+	if (irqlat_tsc)
+		__asm__ __volatile__("rdtsc"
+							 : "=A"(irqlat_start));
+}
+
+// sti()
+void irqlat_sti(void)
+{
+	irqlat_end((unsigned long)__builtin_return_address(0));
+	__sti();
+}
+
+// restore_flags()，只有恢复成开中断状态时才结束计时
+void irqlat_restore(unsigned long flags)
+{
+	if (flags & IF_MASK)
+		irqlat_end((unsigned long)__builtin_return_address(0));
+	__restore_flags(flags);
+}
+
+// 由 schedule() 在切换任务之前调用，结束当前进程的关中断代码段
+// 切换到的进程按自己保存的标志寄存器恢复中断状态，与这一段无关
+void irqlat_switch(void)
+{
+	irqlat_end((unsigned long)__builtin_return_address(0));
+}
+
+// 写 /dev/irqlat，把统计清零
+// 返回：写入的字节数
+int irqlat_write(char *buf, int count)
+{
+	unsigned long flags;
+	int i;
+
+	save_flags(flags);
+	__cli();
+	for (i = 0; i < sizeof(irqlat) / 4; i++)
+		((unsigned long *)irqlat)[i] = 0;
+	irqlat_open = 0;
+	__restore_flags(flags);
+	return count;
+}
+
+#endif
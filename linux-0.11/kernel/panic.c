@@ -28,7 +28,8 @@ volatile void panic(const char *s)
 	printk("Kernel panic: %s\n\r", s);
 	if (current == task[0])
 		printk("In swapper task - not syncing\n\r");
-	else
+	console_flush();
+	if (current != task[0])
 		sys_sync();
 	for (;;)
 		;
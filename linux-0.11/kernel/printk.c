@@ -7,6 +7,11 @@
 // 当处于内核模式时，我们不能使用 printf，因为寄存器 fs 指向其它不感兴趣的地方
 // 自己编制一个 printf 并在使用前保存 fs，一切就解决了
 
+// printk() 不直接写控制台，而是把消息追加到内存中的环形日志缓冲区 log_buf 里：
+// 写入位置用一条 xaddl 指令预留，复制时不关中断，中断处理程序中的 printk() 可以随时嵌套进来。
+// 控制台输出由时钟中断在被中断的是用户程序时分批完成（log_timer()），控制台慢不会拖住打印消息的内核代码。
+// 缓冲区中的消息可以用 syslog() 系统调用读出和清除，滚出屏幕的消息也不会丢失
+
 // 标准参数头文件。以宏的形式定义变量参数列表
 // 主要说明了一个类型 (va_list) 和三个宏 (va_start, va_arg 和va_end)
 // 用于 vsprintf、vprintf、vfprintf 函数
@@ -16,46 +21,234 @@
 // 标准定义头文件。定义了 NULL, offsetof(TYPE, MEMBER)
 #include <stddef.h>
 
+#include <errno.h>
+
 // 内核头文件，含有一些内核常用函数的原形定义
 #include <linux/kernel.h>
+#include <linux/sched.h>
+#include <sys/syslog.h>
+#include <asm/segment.h>
+#include <asm/system.h>
+
+// 日志缓冲区长度，必须是 2 的幂
+#define LOG_BUF_LEN 8192
+#define LOG_MASK (LOG_BUF_LEN - 1)
+
+// 每个时钟滴答最多输出到控制台的字节数，时钟中断处理期间是关中断的
+// 也是每次调用 tty_write() 的最大长度，加上换行时补的回车也不会填满写队列，tty_write() 不会调用 schedule()
+#define LOG_DRAIN_MAX 256
+
+// printk() 最多嵌套的层数（系统调用中被中断，中断处理中又被中断），每层有自己的格式化缓冲区
+#define NR_PRINTK_NEST 3
 
 // 输出缓冲区
-static char buf[1024];
+static char buf[NR_PRINTK_NEST][1024];
+static int printk_depth = 0;
+
+// 下面的位置都是从开机起累计的字节数，取低位得到在 log_buf 中的下标
+// log_end 是已经预留的末尾，log_done 是已经写完的末尾，读的一方只看 log_done 之前的内容
+static char log_buf[LOG_BUF_LEN];
+static unsigned long log_end = 0;
+static unsigned long log_done = 0;
+static int log_writers = 0;			// 正在复制的 printk() 个数
+static unsigned long log_start = 0; // syslog(SYSLOG_ACTION_READ) 读到的位置
+static unsigned long log_clear = 0; // SYSLOG_ACTION_CLEAR 清除到的位置
+static unsigned long con_start = 0; // 控制台输出到的位置
+static struct task_struct *log_wait = NULL;
 
 // 下面该函数 vsprintf() 在 linux/kernel/vsprintf.c
 extern int vsprintf(char *buf, const char *fmt, va_list args);
 
-// 内核使用的显示函数
-int printk(const char *fmt, ...)
+// 原子地把 *p 加上 n，返回原来的值。单 CPU 上一条指令不会被中断打断，不需要 lock 前缀
+static inline unsigned long xadd(unsigned long *p, unsigned long n)
 {
-	// va_list 实际上是一个字符指针类型
-	va_list args;
-	int i;
-
-	// 参数处理开始函数。在 stdarg.h
-	va_start(args, fmt);
+	__asm__ __volatile__("xaddl %0,%1"
+						 : "=r"(n), "=m"(*p)
+						 : "0"(n), "m"(*p));
+	return n;
+}
 
-	// 使用格式串 fmt 将参数列表 args 输出到 buf 中
-	// 返回值 i 等于输出字符串的长度
-	i = vsprintf(buf, fmt, args);
+// 读的一方落后超过一个缓冲区长度时，最旧的内容已被覆盖，跳到还在的最旧位置
+// 位置比较用有符号的差，pos 在 log_done 之后（不应出现）时退回到 log_done，不当作落后了一圈
+static inline unsigned long log_valid(unsigned long pos)
+{
+	if ((long)(log_done - pos) < 0)
+		return log_done;
+	if (log_done - pos > LOG_BUF_LEN)
+		return log_done - LOG_BUF_LEN;
+	return pos;
+}
 
-	// 参数处理结束函数
-	va_end(args);
+// 把日志中从 pos 开始的 n 个字节写到控制台（tty_write() 用 fs 取字节，暂时令 fs = ds）
+// 返回：实际写出的字节数
+static int log_write_console(unsigned long pos, int n)
+{
+	int i;
 
 	__asm__("push %%fs\n\t"		 // 保存 fs
 			"push %%ds\n\t"		 // 压入 ds
 			"pop %%fs\n\t"		 // 弹出 ds 到 fs，也即 令 fs = ds
-			"pushl %0\n\t"		 // 将字符串长度压入堆栈(这三个入栈是调用参数)
-			"pushl $buf\n\t"	 // 将 buf 的地址压入堆栈
-			"pushl $0\n\t"		 // 将数值 0 压入堆栈，是通道号 channel
+			"pushl %2\n\t"		 // 字符串长度
+			"pushl %1\n\t"		 // 字符串地址
+			"pushl $0\n\t"		 // 通道号 channel
 			"call tty_write\n\t" // 调用 tty_write 函数
-			"addl $8,%%esp\n\t"	 // 调用完成恢复栈
-			"popl %0\n\t"		 // 弹出字符串长度值，作为返回值
+			"addl $12,%%esp\n\t" // 调用完成恢复栈
 			"pop %%fs"			 // 恢复原fs 寄存器
-			:					 // 没有输出参数
-			: "r"(i)			 // 输入参数为 i
-			: "ax", "cx", "dx"); // 通知编译器 ax, cx, dx 可能已经改变
+			: "=a"(i)
+			: "r"(log_buf + (pos & LOG_MASK)), "r"(n)
+			: "cx", "dx");
+	return i;
+}
+
+// 把还没输出的日志写到控制台，最多 max 个字节
+static void log_flush(int max)
+{
+	unsigned long end = log_done;
+	int n, i;
+
+	con_start = log_valid(con_start);
+	while (max > 0 && con_start != end)
+	{
+		n = end - con_start;
+		if (n > LOG_BUF_LEN - (con_start & LOG_MASK)) // 不跨过缓冲区末尾
+			n = LOG_BUF_LEN - (con_start & LOG_MASK);
+		if (n > max)
+			n = max;
+		if (n > LOG_DRAIN_MAX)
+			n = LOG_DRAIN_MAX;
+		if ((i = log_write_console(con_start, n)) <= 0)
+			break;
+		con_start += i;
+		max -= i;
+	}
+}
+
+// 由 do_timer() 每个滴答调用一次。只有被中断的是用户程序（cpl 不为 0）时才写控制台，
+// 这时不会有内核代码正在 con_write() 中
+void log_timer(long cpl)
+{
+	if (cpl && con_start != log_done)
+		log_flush(LOG_DRAIN_MAX);
+	if (log_wait && log_start != log_done)
+		wake_up(&log_wait);
+}
+
+// 立即把所有还没输出的日志写到控制台，供 panic() 使用
+void console_flush(void)
+{
+	log_flush(LOG_BUF_LEN);
+}
+
+// 内核使用的显示函数
+int printk(const char *fmt, ...)
+{
+	// va_list 实际上是一个字符指针类型
+	va_list args;
+	unsigned long pos, flags;
+	char *b;
+	int i, k, depth;
+
+	depth = xadd((unsigned long *)&printk_depth, 1);
+	if (depth >= NR_PRINTK_NEST) // 嵌套太深的消息只能丢掉
+	{
+		printk_depth--;
+		return 0;
+	}
+	b = buf[depth];
+
+	// 使用格式串 fmt 将参数列表 args 输出到 b 中，返回值 i 等于输出字符串的长度
+	va_start(args, fmt);
+	i = vsprintf(b, fmt, args);
+	va_end(args);
+
+	// 预留位置后复制。最后一个写完的 printk() 推进 log_done：单 CPU 上嵌套的 printk()
+	// 总是先于被它打断的那个完成，log_writers 回到 0 时 log_end 之前的内容都已写完。
+	// 减少 log_writers 和读 log_end、写 log_done 要在关中断下一起完成，
+	// 否则中间嵌套进来的 printk() 推进 log_done 后，这里会写回较小的旧值
+	xadd((unsigned long *)&log_writers, 1);
+	pos = xadd(&log_end, i);
+	for (k = 0; k < i; k++)
+		log_buf[(pos + k) & LOG_MASK] = b[k];
+	save_flags(flags);
+	cli();
+	if (!--log_writers && (long)(log_end - log_done) > 0)
+		log_done = log_end;
+	restore_flags(flags);
+	printk_depth--;
 
 	//返回输出字符串长度
 	return i;
 }
+
+// 把日志中从 pos 开始的 n 个字节复制到用户缓冲区 buf
+static void log_copy_tofs(char *buf, unsigned long pos, int n)
+{
+	int k = LOG_BUF_LEN - (pos & LOG_MASK);
+
+	if (k > n)
+		k = n;
+	memcpy_tofs(buf, log_buf + (pos & LOG_MASK), k);
+	if (n > k)
+		memcpy_tofs(buf + k, log_buf, n - k);
+}
+
+// 系统调用 syslog：读出或清除日志缓冲区，type 见 include/sys/syslog.h
+// SYSLOG_ACTION_READ_ALL 和 SYSLOG_ACTION_SIZE_BUFFER 任何用户都可以用，其余的需要超级用户
+// 返回：读出的字节数或所要的长度；出错返回负的错误号
+int sys_syslog(int type, char *buf, int len)
+{
+	unsigned long pos, end;
+	int n;
+
+	if (type != SYSLOG_ACTION_READ_ALL && type != SYSLOG_ACTION_SIZE_BUFFER && !suser())
+		return -EPERM;
+	switch (type)
+	{
+	case SYSLOG_ACTION_CLOSE:
+	case SYSLOG_ACTION_OPEN:
+		return 0;
+	case SYSLOG_ACTION_READ:
+		if (!buf || len < 0)
+			return -EINVAL;
+		if (!len)
+			return 0;
+		verify_area(buf, len);
+		while ((log_start = log_valid(log_start)) == log_done)
+		{
+			if (current->signal & ~current->blocked)
+				return -EINTR;
+			interruptible_sleep_on(&log_wait);
+		}
+		n = log_done - log_start;
+		if (n > len)
+			n = len;
+		log_copy_tofs(buf, log_start, n);
+		log_start += n;
+		return n;
+	case SYSLOG_ACTION_READ_ALL:
+	case SYSLOG_ACTION_READ_CLEAR:
+		if (!buf || len < 0)
+			return -EINVAL;
+		verify_area(buf, len);
+		end = log_done;
+		pos = log_clear = log_valid(log_clear);
+		n = end - pos;
+		if (n > len) // 只取最后 len 个字节
+		{
+			pos = end - len;
+			n = len;
+		}
+		log_copy_tofs(buf, pos, n);
+		if (type == SYSLOG_ACTION_READ_CLEAR)
+			log_clear = end;
+		return n;
+	case SYSLOG_ACTION_CLEAR:
+		log_clear = log_done;
+		return 0;
+	case SYSLOG_ACTION_SIZE_UNREAD:
+		return log_done - log_valid(log_start);
+	case SYSLOG_ACTION_SIZE_BUFFER:
+		return LOG_BUF_LEN;
+	}
+	return -EINVAL;
+}
@@ -18,6 +18,9 @@
 // 系统调用头文件，含有 72 个系统调用 C 函数处理程序，以 sys_ 开头
 #include <linux/sys.h>
 
+// 跟踪点
+#include <linux/trace.h>
+
 // 软驱头文件，含有软盘控制器参数的一些定义
 #include <linux/fdreg.h>
 
@@ -208,6 +211,14 @@ void schedule(void)
 				(*p)->alarm = 0;
 			}
 
+			// 如果设置的睡眠超时时刻已到，则唤醒处于可中断睡眠状态的任务
+			if ((*p)->timeout && (*p)->timeout < jiffies)
+			{
+				(*p)->timeout = 0;
+				if ((*p)->state == TASK_INTERRUPTIBLE)
+					(*p)->state = TASK_RUNNING;
+			}
+
 			// 如果信号位图中除被阻塞的信号外还有其它信号，
 			// 并且任务处于可中断状态，则置任务为就绪状态
 			// 其中 ~(_BLOCKABLE & (*p)->blocked) 用于忽略被阻塞的信号
@@ -253,6 +264,11 @@ void schedule(void)
 	// 因此若系统中没有任何其它任务可运行时，则 next 始终为 0
 	// 因此调度函数会在系统空闲时去执行任务 0
 	// 此时任务0 仅执行 pause() 系统调用，并又会调用本函数，在 init/main.c
+	if (task[next] != current)
+		trace(TRACE_SWITCH, current->pid, task[next]->pid);
+#ifdef IRQ_LATENCY
+	irqlat_switch();
+#endif
 	switch_to(next);
 }
 
@@ -288,6 +304,7 @@ void sleep_on(struct task_struct **p)
 
 	// 将睡眠队列头的等待指针指向当前任务
 	*p = current;
+	trace(TRACE_SLEEP, p, 0);
 
 	// 将当前任务置为不可中断的等待状态
 	current->state = TASK_UNINTERRUPTIBLE;
@@ -321,6 +338,7 @@ void interruptible_sleep_on(struct task_struct **p)
 
 	// 将睡眠队列头的等待指针指向当前任务
 	*p = current;
+	trace(TRACE_SLEEP, p, 1);
 repeat:
 	// 将当前任务置为可中断的等待状态
 	current->state = TASK_INTERRUPTIBLE;
@@ -352,10 +370,16 @@ void wake_up(struct task_struct **p)
 {
 	if (p && *p)
 	{
+		trace(TRACE_WAKEUP, p, (*p)->pid);
+
 		// 置为就绪（可运行）状态
 		(**p).state = 0;
 		*p = NULL;
 	}
+
+	// 同时唤醒在 select()/poll() 中登记等待该队列的进程
+	if (select_nr)
+		select_wake(p);
 }
 
 // 好了，从这里开始是一些有关软盘的子程序，本不应该放在内核的主要部分中的
@@ -562,10 +586,52 @@ void add_timer(long jiffies, void (*fn)(void))
 	sti();
 }
 
+// 内核态 PC 采样直方图，编译时定义了 PROF_SHIFT 才会由 prof_init() 在启动时分配
+// 每个计数对应内核代码中 2^prof_shift 字节的一段，时钟中断打断内核代码时把所在一段的计数加 1，
+// 最后一个计数收集超出内核代码范围的采样。通过 /dev/profile 读出，写该设备则把计数清零
+unsigned long *prof_buffer = NULL;
+unsigned long prof_len = 0;
+unsigned long prof_shift = 0;
+
+// 在主内存开始处 mem_start 分配内核 PC 采样直方图，由 init/main.c 在 mem_init() 之前调用
+// 返回：占用的内存字节数（按页面取整）
+long prof_init(long mem_start, int shift)
+{
+	extern int etext;
+	long size;
+	unsigned long i;
+
+	prof_shift = shift;
+	prof_len = ((unsigned long)&etext >> shift) + 1;
+	prof_buffer = (unsigned long *)mem_start;
+	for (i = 0; i < prof_len; i++)
+		prof_buffer[i] = 0;
+	size = (prof_len * sizeof(long) + 4095) & ~4095;
+	return size;
+}
+
+// 把用户程序地址 eip 计入当前进程用 profil() 设置的缓冲区
+// 只在时钟中断打断用户程序时调用，此时相当于当前进程在内核中执行，访问用户缓冲区可以缺页；
+// 写之前先验证页面，这样 fork() 后与子进程共享的缓冲区页面会先被复制
+static void profil_tick(unsigned long eip)
+{
+	unsigned short *p;
+	unsigned long i;
+
+	if (eip < current->prof_off)
+		return;
+	i = ((unsigned long long)(eip - current->prof_off) * current->prof_scale) >> 17;
+	if (i >= current->prof_size / 2)
+		return;
+	p = current->prof_buf + i;
+	verify_area(p, 2);
+	put_fs_word(get_fs_word(p) + 1, p);
+}
+
 // 时钟中断 C 函数处理程序，在 kernel/system_call.s 中的 timer_interrupt 中被调用
-// 参数 cpl 是当前特权级 0 或 3，0 表示内核代码在执行
+// 参数 cpl 是当前特权级 0 或 3，0 表示内核代码在执行；eip 是被中断处的地址，用于 PC 采样
 // 对于一个进程由于执行时间片用完时，则进行任务切换，并执行一个计时更新工作
-void do_timer(long cpl)
+void do_timer(long cpl, unsigned long eip)
 {
 	// 扬声器发声时间滴答数 kernel/chr_drv/console.c
 	extern int beepcount;
@@ -588,6 +654,18 @@ void do_timer(long cpl)
 	else
 		current->stime++;
 
+	// PC 采样：被中断的是用户程序时计入进程用 profil() 设置的缓冲区，是内核代码时计入内核直方图
+	if (cpl && current->prof_scale > 1)
+		profil_tick(eip);
+	else if (!cpl && prof_buffer)
+	{
+		eip >>= prof_shift;
+		prof_buffer[eip < prof_len ? eip : prof_len - 1]++;
+	}
+
+	// 把 printk() 的消息输出到控制台，唤醒等待日志的进程
+	log_timer(cpl);
+
 	// 如果有用户的定时器存在，则将链表第 1 个定时器的值减 1。如果已等于 0
 	// 则调用相应的处理程序，并将该处理程序指针置为空，然后去掉该项定时器
 	if (next_timer)
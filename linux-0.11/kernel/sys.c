@@ -26,6 +26,9 @@
 // 系统名称结构头文件
 #include <sys/utsname.h>
 
+// profil() 的参数结构
+#include <sys/profil.h>
+
 // 返回日期和时间
 int sys_ftime()
 {
@@ -61,9 +64,35 @@ int sys_rename()
 	return -ENOSYS;
 }
 
-int sys_prof()
+// 系统调用 profil()，设置当前进程的用户态 PC 采样
+// 以后每个时钟滴答若打断的是用户程序，就把地址 eip 对应的计数 buf[((eip - offset) * scale >> 16) / 2] 加 1
+// 由于参数多于 3 个，用户程序通过 prof_arg_struct 结构指针 arg 传递参数；scale 为 0 或 1 时关闭采样
+// 返回：0 表示成功，出错返回出错码
+int sys_prof(struct prof_arg_struct *arg)
 {
-	return -ENOSYS;
+	struct prof_arg_struct a;
+	int i;
+
+	// 从用户空间复制参数
+	for (i = 0; i < sizeof(a) / 4; i++)
+		((unsigned long *)&a)[i] = get_fs_long(((unsigned long *)arg) + i);
+	if (a.scale <= 1)
+	{
+		current->prof_scale = 0;
+		return 0;
+	}
+	// 缓冲区必须按字对齐，并且在进程的 64MB 空间内
+	if (((unsigned long)a.buf & 1) || a.size < 2 || a.size > 0x4000000 ||
+		(unsigned long)a.buf > 0x4000000 - a.size)
+		return -EINVAL;
+
+	// 先验证整个缓冲区，以后时钟中断中通常就不必再复制页面
+	verify_area(a.buf, a.size);
+	current->prof_buf = a.buf;
+	current->prof_size = a.size;
+	current->prof_off = a.offset;
+	current->prof_scale = a.scale;
+	return 0;
 }
 
 // 设置当前任务的实际以及/或者有效组ID（gid）
@@ -224,9 +253,10 @@ int sys_times(struct tms *tbuf)
 // 该函数并不被用户直接调用，而由 libc 库函数进行包装，并且返回值也不一样
 int sys_brk(unsigned long end_data_seg)
 {
-	// 如果参数>代码结尾，并且小于堆栈 - 16KB
+	// 如果参数>代码结尾，并且小于堆栈 - 16KB，也不能进入共享内存段附加区和文件映射区范围
 	if (end_data_seg >= current->end_code &&
-		end_data_seg < current->start_stack - 16384)
+		end_data_seg < current->start_stack - 16384 &&
+		end_data_seg <= SHM_START)
 		// 则设置新数据段结尾值
 		current->brk = end_data_seg;
 
@@ -0,0 +1,78 @@
+/*
+ *  linux/kernel/sysstat.c
+ */
+
+// 系统调用统计：每个调用号的调用次数，以及耗时（CPU 周期数）的对数分布
+// 只有编译时打开了 SYSCALL_STATS 选项才会编译进内核，这时 kernel/system_call.s 在调用系统调用处理函数之前
+// 调用 sysstat_enter() 记下调用号和时间戳，处理函数返回之后调用 sysstat_exit() 计入统计
+// 耗时包括进程在系统调用中睡眠的时间，因此读终端、等待子进程等调用的分布会落在很高的格中
+
+#ifdef SYSCALL_STATS
+
+#include <errno.h>
+#include <sys/types.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/trace.h>
+#include <linux/sysstat.h>
+#include <asm/system.h>
+
+struct syscall_stat sysstat[NR_SYSSTAT];
+
+// CPU 是否有时间戳计数器，-1 表示还没有检查
+static int sysstat_tsc = -1;
+
+// 进入系统调用，nr 是调用号（已经由 system_call 检查过范围）
+void sysstat_enter(long nr)
+{
+	if (sysstat_tsc < 0)
+		sysstat_tsc = has_tsc();
+	current->sys_nr = nr;
+	if (sysstat_tsc)
+		__asm__ __volatile__("rdtsc"
+							 : "=A"(current->sys_start));
+}
+
+// 系统调用处理函数返回，计入调用次数和耗时
+// execve() 成功后仍然从这里返回；fork() 的子进程和 exit() 不会经过这里，只有调用者一方计入
+void sysstat_exit(void)
+{
+	struct syscall_stat *s = sysstat + current->sys_nr;
+	unsigned long long t;
+	unsigned long hi, lo;
+	int i;
+
+	s->count++;
+	if (!sysstat_tsc)
+		return;
+	__asm__ __volatile__("rdtsc"
+						 : "=A"(t));
+	t -= current->sys_start;
+	hi = t >> 32;
+	lo = t;
+	if (hi)
+		i = NR_SYSSTAT_HIST - 1;
+	else if (lo)
+		__asm__("bsrl %1,%0"
+				: "=r"(i)
+				: "r"(lo));
+	else
+		i = 0;
+	s->hist[i]++;
+}
+
+// 写 /dev/sysstat，把统计清零
+// 返回：写入的字节数
+int sysstat_write(char *buf, int count)
+{
+	int i;
+
+	cli();
+	for (i = 0; i < sizeof(sysstat) / 4; i++)
+		((unsigned long *)sysstat)[i] = 0;
+	sti();
+	return count;
+}
+
+#endif
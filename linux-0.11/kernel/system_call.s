@@ -79,8 +79,8 @@ sa_flags = 8
 # 恢复函数指针，参见 kernel/signal.c
 sa_restorer = 12
 
-# Linux 0.11 版内核中的系统调用总数
-nr_system_calls = 72
+# 内核中的系统调用总数
+nr_system_calls = 95
 
 # 好了，在使用软驱时我收到了并行打印机中断，很奇怪。呵，现在不管它
 
@@ -136,10 +136,36 @@ system_call:
 	# 下面这句操作数的含义是：调用地址 = sys_call_table + %eax * 4
 	# 对应的 C 程序中的 sys_call_table 在 include/linux/sys.h 中
 	# 其中定义了一个包括 72 个 系统调用 C 处理函数的地址数组表
+	# 打开了跟踪时先记录调用号和第 1 个参数，trace_syscall() 在 kernel/trace.c 中
+	cmpl $0,trace_on
+	je 1f
+	pushl %ebx
+	pushl %eax
+	call trace_syscall
+	popl %eax
+	addl $4,%esp
+1:
+.ifdef SYSCALL_STATS
+	# 编译时打开了系统调用统计，则记下调用号和开始时刻，sysstat_enter() 在 kernel/sysstat.c 中
+	pushl %eax
+	call sysstat_enter
+	popl %eax
+.endif
 	call *sys_call_table(,%eax,4)
 
 	# 把系统调用返回值入栈
 	pushl %eax
+.ifdef SYSCALL_STATS
+	call sysstat_exit
+.endif
+
+	# 打开了跟踪时记录返回值。sysstat_exit() 会改变 eax，返回值取栈顶保存的那份
+	cmpl $0,trace_on
+	je 1f
+	pushl (%esp)
+	call trace_sysret
+	addl $4,%esp
+1:
 
 	# 取当前任务（进程）数据结构地址 -> eax
 	movl current,%eax
@@ -348,16 +374,17 @@ timer_interrupt:
 	movb $0x20,%al
 	outb %al,$0x20
 
-	# 下面 3 句从选择符中取出当前特权级别 (0 或 3) 并压入堆栈，作为 do_timer 的参数
+	# 下面从选择符中取出当前特权级别 (0 或 3)，与被中断处的 eip 一起压入堆栈，作为 do_timer 的参数
 	movl CS(%esp),%eax
 	andl $3,%eax
+	pushl EIP(%esp)
 	pushl %eax
 
-	# do_timer(CPL) 执行任务切换、计时等工作，在 kernel/shched.c 中实现
+	# do_timer(CPL, EIP) 执行任务切换、计时等工作，在 kernel/shched.c 中实现
 	call do_timer
 
 	# 调用完成恢复栈
-	addl $4,%esp
+	addl $8,%esp
 	jmp ret_from_sys_call
 
 # 内存 4 字节对齐
@@ -0,0 +1,164 @@
+/*
+ *  linux/kernel/trace.c
+ */
+
+// 内核跟踪环形缓冲区
+// 分布在调度、高速缓冲、块设备和系统调用中的跟踪点把事件以二进制形式记录在这里，
+// 不像 printk() 那样同步地经过 tty_write()/con_write() 输出，因此几乎不改变被观察代码的时序
+// 记录可以在中断中进行，只在写一项记录时短暂关中断；缓冲区满时覆盖最旧的记录，并在读出时报告丢失数
+// 读 /dev/trace 按顺序取走记录，没有记录时等待，直到关闭跟踪
+
+#include <errno.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/trace.h>
+#include <asm/segment.h>
+#include <asm/system.h>
+
+// 环形缓冲区的项数，必须是 2 的幂
+#define NR_TRACE 512
+
+static struct trace_entry trace_buf[NR_TRACE];
+static unsigned long trace_head = 0, trace_tail = 0;
+static unsigned long trace_lost = 0;
+static int trace_tsc = 0;
+int trace_on = 0;
+
+// 检查 CPU 是否有时间戳计数器：先检查 EFLAGS 中的 ID 位（位 21）能否改变，
+// 能改变说明支持 cpuid 指令，再看 cpuid 功能 1 返回的 edx 位 4
+int has_tsc(void)
+{
+	unsigned long a, b;
+
+	__asm__("pushfl\n\t"
+			"popl %0\n\t"
+			"movl %0,%1\n\t"
+			"xorl $0x200000,%0\n\t"
+			"pushl %0\n\t"
+			"popfl\n\t"
+			"pushfl\n\t"
+			"popl %0\n\t"
+			"pushl %1\n\t"
+			"popfl"
+			: "=&r"(a), "=&r"(b));
+	if (!((a ^ b) & 0x200000))
+		return 0;
+	__asm__("cpuid"
+			: "=d"(a)
+			: "a"(1)
+			: "bx", "cx");
+	return (a >> 4) & 1;
+}
+
+// 记录一个跟踪事件，由 trace() 宏在打开跟踪时调用，可能在中断中执行
+// 保存并恢复标志寄存器而不是直接开中断，因为调用者可能正处于关中断状态
+void trace_event(int event, unsigned long a, unsigned long b)
+{
+	struct trace_entry *e;
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	e = trace_buf + trace_head;
+	trace_head = (trace_head + 1) & (NR_TRACE - 1);
+	if (trace_head == trace_tail)
+	{
+		trace_tail = (trace_tail + 1) & (NR_TRACE - 1);
+		trace_lost++;
+	}
+	if (trace_tsc)
+		__asm__ __volatile__("rdtsc"
+							 : "=A"(e->tsc));
+	else
+		e->tsc = 0;
+	e->jiffies = jiffies;
+	e->event = event;
+	e->pid = current->pid;
+	e->a = a;
+	e->b = b;
+	restore_flags(flags);
+}
+
+// 系统调用入口和返回的跟踪点，由 kernel/system_call.s 在打开跟踪时调用
+void trace_syscall(long nr, long arg)
+{
+	trace_event(TRACE_SYSCALL, nr, arg);
+}
+
+void trace_sysret(long ret)
+{
+	trace_event(TRACE_SYSRET, ret, 0);
+}
+
+// 读 /dev/trace，按顺序取走记录复制到用户缓冲区 buf 中，只复制完整的记录
+// 有记录被覆盖时，先读出一项 TRACE_LOST 记录
+// 没有记录时等待：跟踪点不能唤醒进程（wake_up() 本身就是跟踪点），因此每隔 1/10 秒检查一次
+// 返回：读出的字节数；跟踪已关闭且没有记录时返回 0；等待时收到信号返回 -EINTR
+int trace_read(char *buf, int count)
+{
+	struct trace_entry e;
+	int n = 0;
+
+	if (count < (int)sizeof(e))
+		return -EINVAL;
+	while (count - n >= (int)sizeof(e))
+	{
+		cli();
+		if (trace_lost)
+		{
+			e.tsc = 0;
+			e.jiffies = jiffies;
+			e.event = TRACE_LOST;
+			e.pid = 0;
+			e.a = trace_lost;
+			e.b = 0;
+			trace_lost = 0;
+		}
+		else if (trace_tail != trace_head)
+		{
+			e = trace_buf[trace_tail];
+			trace_tail = (trace_tail + 1) & (NR_TRACE - 1);
+		}
+		else
+		{
+			sti();
+			if (n || !trace_on || (current->signal & ~current->blocked))
+				break;
+			current->timeout = jiffies + HZ / 10;
+			current->state = TASK_INTERRUPTIBLE;
+			schedule();
+			current->timeout = 0;
+			continue;
+		}
+		sti();
+		memcpy_tofs(buf + n, &e, sizeof(e));
+		n += sizeof(e);
+	}
+	if (!n && trace_on)
+		return -EINTR;
+	return n;
+}
+
+// 写 /dev/trace 控制跟踪：第 1 个字符为 '1' 时清空缓冲区并打开跟踪，为 '0' 时关闭跟踪
+// 返回：写入的字节数，其它字符返回 -EINVAL
+int trace_write(char *buf, int count)
+{
+	if (count <= 0)
+		return 0;
+	switch (get_fs_byte(buf))
+	{
+	case '1':
+		trace_tsc = has_tsc();
+		cli();
+		trace_head = trace_tail = trace_lost = 0;
+		trace_on = 1;
+		sti();
+		return count;
+	case '0':
+		trace_on = 0;
+		return count;
+	default:
+		return -EINVAL;
+	}
+}
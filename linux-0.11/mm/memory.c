@@ -16,12 +16,14 @@
 // 对 invalidate() 函数也进行了修正 - 在这方面我还做的不够
 
 #include <signal.h>
+#include <sys/mman.h>
 
 #include <asm/system.h>
 
 #include <linux/sched.h>
 #include <linux/head.h>
 #include <linux/kernel.h>
+#include <linux/trace.h>
 
 // 进程退出处理函数，在 kernel/exit.c
 void do_exit(long code);
@@ -205,6 +207,62 @@ int free_page_tables(unsigned long from, unsigned long size)
 	return 0;
 }
 
+// 通过页目录和页表取得线性地址 address 对应的物理地址
+// 若页表或页面不存在，则返回 0
+unsigned long get_phys_addr(unsigned long address)
+{
+	unsigned long page;
+
+	// 取页目录项，页表不存在则返回
+	page = *(unsigned long *)((address >> 20) & 0xffc);
+	if (!(page & 1))
+		return 0;
+
+	// 取页表项，页面不存在则返回
+	page = ((unsigned long *)(0xfffff000 & page))[(address >> 12) & 0x3ff];
+	if (!(page & 1))
+		return 0;
+	return (0xfffff000 & page) + (address & 0xfff);
+}
+
+// 置线性地址 address 所在页面的页表项中的已修改标志（位 6）
+// 直接 I/O 读操作按物理地址写入用户页面，CPU 不会设置该标志，
+// 不置上的话 share_page() 和 share_mmap_page() 会把页面当作干净的文件数据共享给别的进程
+void set_page_dirty(unsigned long address)
+{
+	unsigned long page;
+
+	page = *(unsigned long *)((address >> 20) & 0xffc);
+	if (!(page & 1))
+		return;
+	((unsigned long *)(0xfffff000 & page))[(address >> 12) & 0x3ff] |= 0x40;
+}
+
+// 释放线性地址 from 开始 size 字节范围内已映射的页面，并将对应页表项清零
+// 与 free_page_tables() 不同，这里不要求 4M 对齐，也不释放页表本身
+// munmap() 撤销文件映射区时使用该函数，from 和 size 都须以页面为边界
+void free_page_range(unsigned long from, unsigned long size)
+{
+	unsigned long *dir, *pg_table;
+
+	for (; size; size -= PAGE_SIZE, from += PAGE_SIZE)
+	{
+		// 页表不存在，则该地址上也不会有页面
+		dir = (unsigned long *)((from >> 20) & 0xffc);
+		if (!(1 & *dir))
+			continue;
+
+		// 取页表项，若页面存在则释放它，然后清页表项
+		pg_table = (unsigned long *)(0xfffff000 & *dir) + ((from >> 12) & 0x3ff);
+		if (1 & *pg_table)
+			free_page(0xfffff000 & *pg_table);
+		*pg_table = 0;
+	}
+
+	// 刷新页变换高速缓冲
+	invalidate();
+}
+
 /*
  *  Well, here is one of the most complicated functions in mm. It
  * copies a range of linerar addresses by copying only the pages.
@@ -337,6 +395,37 @@ int copy_page_tables(unsigned long from, unsigned long to, long size)
 	return 0;
 }
 
+// 在页目录和页表中设置线性地址 address 处的页表项，使其指向物理页面 page
+// 页表不存在时申请一页作为页表，申请不到则返回 0
+static unsigned long map_page(unsigned long page, unsigned long address)
+{
+	unsigned long tmp, *page_table;
+
+	// 注意!!! 这里使用了页目录基址 pg_dir=0 的条件
+
+	// 计算指定地址在页目录表中对应的目录项指针
+	page_table = (unsigned long *)((address >> 20) & 0xffc);
+
+	// 如果该目录项有效(P=1)(也即指定的页表在内存中)，则从中取得指定页表的地址 -> page_table
+	if ((*page_table) & 1)
+		page_table = (unsigned long *)(0xfffff000 & *page_table);
+	else
+	{
+		// 否则，申请空闲页面给页表使用，并在对应目录项中置相应标志 7（User, U/S, R/W）
+		// 然后将该页表的地址 -> page_table
+		if (!(tmp = get_free_page()))
+			return 0;
+		*page_table = tmp | 7;
+		page_table = (unsigned long *)tmp;
+	}
+
+	// 在页表中设置指定地址的物理内存页面的页表项内容，每个页表共可有 1024 项(0x3ff)
+	page_table[(address >> 12) & 0x3ff] = page | 7;
+
+	// 不需要刷新页变换高速缓冲
+	return page;
+}
+
 /*
  * This function puts a page in memory at the wanted address.
  * It returns the physical address of the page gotten, 0 if
@@ -356,10 +445,6 @@ int copy_page_tables(unsigned long from, unsigned long to, long size)
 // 因此当修改了一个无效的页表项时不需要刷新，在此就表现为不用调用 invalidate() 函数
 unsigned long put_page(unsigned long page, unsigned long address)
 {
-	unsigned long tmp, *page_table;
-
-	// 注意!!! 这里使用了页目录基址 pg_dir=0 的条件
-
 	// 如果申请的页面位置低于 LOW_MEM(1Mb)
 	// 或超出系统实际含有内存高端 HIGH_MEMORY，则发出警告
 	if (page < LOW_MEM || page >= HIGH_MEMORY)
@@ -368,27 +453,22 @@ unsigned long put_page(unsigned long page, unsigned long address)
 	// 如果申请的页面在内存页面映射字节图中没有置位，则显示警告信息
 	if (mem_map[(page - LOW_MEM) >> 12] != 1)
 		printk("mem_map disagrees with %p at %p\n", page, address);
+	return map_page(page, address);
+}
 
-	// 计算指定地址在页目录表中对应的目录项指针
-	page_table = (unsigned long *)((address >> 20) & 0xffc);
-
-	// 如果该目录项有效(P=1)(也即指定的页表在内存中)，则从中取得指定页表的地址 -> page_table
-	if ((*page_table) & 1)
-		page_table = (unsigned long *)(0xfffff000 & *page_table);
-	else
+// 把已被引用的物理页面 page 再映射到线性地址 address 处，并增加页面的引用次数
+// 共享内存段的页面同时映射在多个进程中，引用次数大于 1，因此不能使用 put_page()
+// 返回：页面地址，取不到页表页面则返回 0
+unsigned long put_shared_page(unsigned long page, unsigned long address)
+{
+	if (page < LOW_MEM || page >= HIGH_MEMORY || !mem_map[MAP_NR(page)])
 	{
-		// 否则，申请空闲页面给页表使用，并在对应目录项中置相应标志 7（User, U/S, R/W）
-		// 然后将该页表的地址 -> page_table
-		if (!(tmp = get_free_page()))
-			return 0;
-		*page_table = tmp | 7;
-		page_table = (unsigned long *)tmp;
+		printk("Trying to share page %p at %p\n", page, address);
+		return 0;
 	}
-
-	// 在页表中设置指定地址的物理内存页面的页表项内容，每个页表共可有 1024 项(0x3ff)
-	page_table[(address >> 12) & 0x3ff] = page | 7;
-
-	// 不需要刷新页变换高速缓冲
+	if (!map_page(page, address))
+		return 0;
+	mem_map[MAP_NR(page)]++;
 	return page;
 }
 
@@ -446,6 +526,9 @@ void un_wp_page(unsigned long *table_entry)
 // 写共享页面时，需复制页面（写时复制）
 void do_wp_page(unsigned long error_code, unsigned long address)
 {
+	struct mmap_struct *area;
+
+	trace(TRACE_PAGE_FAULT, address, error_code);
 #if 0
 	// 我们现在还不能这样做：因为 estdio 库会在代码空间执行写操作 
 	// 真是太愚蠢了。我真想从 GNU 得到 libc.a 库。
@@ -454,6 +537,21 @@ void do_wp_page(unsigned long error_code, unsigned long address)
 	if (CODE_SPACE(address))
 		do_exit(SIGSEGV);
 #endif
+	// 对不可写的文件映射区（只读共享映射或只读私有映射）执行写操作，则以段错误退出
+	// 可写的私有映射与普通数据页面一样，通过下面的写时复制得到自己的页面
+	if ((area = find_mmap(address - current->start_code)) &&
+		!(area->prot & PROT_WRITE))
+		do_exit(SIGSEGV);
+
+	// 共享内存段的页面在 fork() 后也被置为只读，但各进程应看到同一页面，因此只恢复可写
+	if (find_shm(address - current->start_code))
+	{
+		*(unsigned long *)(((address >> 10) & 0xffc) + (0xfffff000 &
+						   *((unsigned long *)((address >> 20) & 0xffc)))) |= 2;
+		invalidate();
+		return;
+	}
+
 	// 处理取消页面保护，参数指定页面在页表中的页表项指针，其计算方法是：
 	// ((address>>10) & 0xffc)：计算指定地址的页面在页表中的偏移地址；
 	// (0xfffff000 & *((address>>20) &0xffc))：取目录项中页表的地址值；
@@ -467,8 +565,15 @@ void do_wp_page(unsigned long error_code, unsigned long address)
 // 若页面不可写，则复制页面
 void write_verify(unsigned long address)
 {
+	struct mmap_struct *area;
 	unsigned long page;
 
+	// 内核写用户页面时 CPU 不检查写保护，下面的写时复制又会把页面变成可写的，
+	// 因此与 do_wp_page() 一样，向不可写的文件映射区写数据（如 read() 读入其中）时以段错误退出
+	if ((area = find_mmap(address - current->start_code)) &&
+		!(area->prot & PROT_WRITE))
+		do_exit(SIGSEGV);
+
 	// 判断指定地址所对应页目录项的页表是否存在(P)，若不存在 (P=0) 则返回
 	if (!((page = *((unsigned long *)((address >> 20) & 0xffc))) & 1))
 		return;
@@ -478,8 +583,17 @@ void write_verify(unsigned long address)
 	page += ((address >> 10) & 0xffc);
 
 	// 如果该页面不可写(标志 R/W 没有置位)，则执行共享检验和复制页面操作（写时复制）
+	// 共享内存段的页面不复制，只恢复可写
 	if ((3 & *(unsigned long *)page) == 1)
-		un_wp_page((unsigned long *)page);
+	{
+		if (find_shm(address - current->start_code))
+		{
+			*(unsigned long *)page |= 2;
+			invalidate();
+		}
+		else
+			un_wp_page((unsigned long *)page);
+	}
 	return;
 }
 
@@ -502,15 +616,13 @@ void get_empty_page(unsigned long address)
 	}
 }
 
-// try_to_share() 在任务 p 中检查位于地址 address 处的页面
-// 看页面是否存在，是否干净，如果是干净的话，就与当前任务共享
-
-// 注意！这里我们已假定 p != 当前任务，并且它们共享同一个执行程序
-
-// 尝试对进程指定地址处的页面进行共享操作
-// 同时还验证指定的地址处是否已经申请了页面，若是则出错，死机
+// 共享页面的实际操作，参数都是线性地址：
+// from_address - 已存在的页面所在线性地址，页面必须存在并且是干净的；
+// to_address - 需要共享该页面的线性地址（当前进程中，页面尚不存在）
+// 文件映射区（mmap）的页面也使用这个函数共享，
+// 此时两个地址在各自进程空间中的偏移可以不同
 // 返回 1-成功，0-失败
-static int try_to_share(unsigned long address, struct task_struct *p)
+static int share_linear_page(unsigned long from_address, unsigned long to_address)
 {
 	unsigned long from;
 	unsigned long to;
@@ -518,14 +630,9 @@ static int try_to_share(unsigned long address, struct task_struct *p)
 	unsigned long to_page;
 	unsigned long phys_addr;
 
-	// 求指定内存地址的页目录项
-	from_page = to_page = ((address >> 20) & 0xffc);
-
-	// 计算进程 p 的代码起始地址所对应的页目录项
-	from_page += ((p->start_code >> 20) & 0xffc);
-
-	// 计算当前进程中代码起始地址所对应的页目录项
-	to_page += ((current->start_code >> 20) & 0xffc);
+	// 分别求两个线性地址所对应的页目录项
+	from_page = ((from_address >> 20) & 0xffc);
+	to_page = ((to_address >> 20) & 0xffc);
 
 	// 在from 处是否存在页目录？
 
@@ -537,7 +644,7 @@ static int try_to_share(unsigned long address, struct task_struct *p)
 	from &= 0xfffff000;
 
 	// 计算地址对应的页表项指针值，并取出该页表项内容 -> phys_addr
-	from_page = from + ((address >> 10) & 0xffc);
+	from_page = from + ((from_address >> 10) & 0xffc);
 	phys_addr = *(unsigned long *)from_page;
 
 	// 页面干净并且存在吗？
@@ -567,7 +674,7 @@ static int try_to_share(unsigned long address, struct task_struct *p)
 	// 取对应页表地址 -> to，页表项地址 -> to_page
 	// 如果对应的页面已经存在，则出错，死机
 	to &= 0xfffff000;
-	to_page = to + ((address >> 10) & 0xffc);
+	to_page = to + ((to_address >> 10) & 0xffc);
 	if (1 & *(unsigned long *)to_page)
 		panic("try_to_share: to_page already exists");
 
@@ -587,6 +694,21 @@ static int try_to_share(unsigned long address, struct task_struct *p)
 	return 1;
 }
 
+// try_to_share() 在任务 p 中检查位于地址 address 处的页面
+// 看页面是否存在，是否干净，如果是干净的话，就与当前任务共享
+
+// 注意！这里我们已假定 p != 当前任务，并且它们共享同一个执行程序
+
+// 尝试对进程指定地址处的页面进行共享操作
+// 同时还验证指定的地址处是否已经申请了页面，若是则出错，死机
+// 返回 1-成功，0-失败
+static int try_to_share(unsigned long address, struct task_struct *p)
+{
+	// 地址是相对于进程代码起始处的，加上各自的基址即得线性地址
+	return share_linear_page(p->start_code + address,
+							 current->start_code + address);
+}
+
 /*
  * share_page() tries to find a process that could share a page with
  * the current one. Address is the address of the wanted page relative
@@ -640,6 +762,89 @@ static int share_page(unsigned long address)
 	return 0;
 }
 
+// 文件映射区的页面共享
+// pos 是缺页地址在被映射文件中的偏移，address 是缺页的线性地址
+// 在所有进程的映射区中寻找映射了同一文件同一位置的页面，若页面存在并且干净就共享它
+// 这样多个进程映射同一个文件时，只读的页面在内存中只有一份
+// 返回 1 - 成功，0 - 失败
+static int share_mmap_page(struct m_inode *inode, unsigned long pos, unsigned long address)
+{
+	struct task_struct **p;
+	struct mmap_struct *m;
+
+	for (p = &LAST_TASK; p > &FIRST_TASK; --p)
+	{
+		if (!*p)
+			continue;
+		for (m = (*p)->mmap; m < (*p)->mmap + NR_MMAP; m++)
+		{
+			// 映射的不是同一个文件，或者没有覆盖该文件位置，则继续
+			if (m->inode != inode)
+				continue;
+			if (pos < m->offset || pos - m->offset >= m->end - m->start)
+				continue;
+			if (share_linear_page((*p)->start_code + m->start + (pos - m->offset), address))
+				return 1;
+		}
+	}
+	return 0;
+}
+
+// 处理文件映射区中的缺页，与执行文件的按需加载类似
+// 先尝试与其它映射区共享页面，否则读入文件中对应的 4 个数据块
+// 新页面映射为只读，以便以后能被共享，并使写操作进入 do_wp_page() 处理；
+// 只有对可写私有映射区的写操作引起的缺页，才直接映射为可写页面。这种情况不能共享：
+// 内核态写用户空间时 CR0.WP 为 0，只读的共享页面会被直接写入，其它进程也会看到
+static void do_mmap_page(struct mmap_struct *area, unsigned long error_code,
+						 unsigned long address)
+{
+	struct m_inode *inode = area->inode;
+	unsigned long pos, page, tmp;
+	int nr[4];
+	int block, i, private_write;
+
+	private_write = (error_code & 2) && (area->flags & MAP_PRIVATE) &&
+					(area->prot & PROT_WRITE);
+
+	// 计算缺页地址在文件中的偏移
+	pos = area->offset + (address - current->start_code - area->start);
+	if (!private_write && share_mmap_page(inode, pos, address))
+		return;
+
+	if (!(page = get_free_page()))
+		oom();
+
+	// 取页面对应的 4 个逻辑块号，超出文件长度的块不读，页面中相应部分保持为 0
+	block = pos / BLOCK_SIZE;
+	for (i = 0; i < 4; block++, i++)
+		nr[i] = (block * BLOCK_SIZE < inode->i_size) ? bmap(inode, block) : 0;
+	bread_page(page, inode->i_dev, nr);
+
+	// 文件最后一块中超出文件长度的部分清零
+	if (pos < inode->i_size && pos + PAGE_SIZE > inode->i_size)
+	{
+		i = pos + PAGE_SIZE - inode->i_size;
+		tmp = page + PAGE_SIZE;
+		while (i-- > 0)
+		{
+			tmp--;
+			*(char *)tmp = 0;
+		}
+	}
+
+	if (!put_page(page, address))
+	{
+		free_page(page);
+		oom();
+	}
+
+	// put_page() 设置的是可读写页面，除写私有映射外都要去掉 R/W 标志
+	// 页表项原来无效，因此不需要刷新页变换高速缓冲
+	if (!private_write)
+		*(unsigned long *)(((address >> 10) & 0xffc) + (0xfffff000 &
+														 *((unsigned long *)((address >> 20) & 0xffc)))) &= ~2;
+}
+
 // 页异常中断处理调用的函数，处理缺页异常情况，在 page.s 程序中被调用
 // 参数 error_code 是由 CPU 自动产生，address 是页面线性地址
 void do_no_page(unsigned long error_code, unsigned long address)
@@ -648,6 +853,9 @@ void do_no_page(unsigned long error_code, unsigned long address)
 	unsigned long tmp;
 	unsigned long page;
 	int block, i;
+	struct mmap_struct *area;
+
+	trace(TRACE_PAGE_FAULT, address, error_code);
 
 	// 页面地址
 	address &= 0xfffff000;
@@ -655,6 +863,13 @@ void do_no_page(unsigned long error_code, unsigned long address)
 	// 首先算出指定线性地址 在进程空间中 相对于进程基址的偏移长度值
 	tmp = address - current->start_code;
 
+	// 如果缺页地址位于文件映射区中，则由被映射的文件提供页面
+	if ((area = find_mmap(tmp)))
+	{
+		do_mmap_page(area, error_code, address);
+		return;
+	}
+
 	// 若当前进程的 executable 空，或者指定地址超出代码 + 数据长度
 	// 则申请一页物理内存，并映射影射到指定的线性地址处
 	// executable 是进程的 i 节点结构。该值为 0，表明进程刚开始设置，需要内存；
@@ -738,6 +953,44 @@ void mem_init(long start_mem, long end_mem)
 		mem_map[i++] = 0;
 }
 
+// 统计主内存区的页面使用情况，供 proc 文件系统的 meminfo 使用
+// mem_map[] 中为 USED 的是主内存区中不参与分页的页面（虚拟盘、内核 PC 采样直方图等）
+void mem_usage(unsigned long *total, unsigned long *free,
+			   unsigned long *shared, unsigned long *reserved)
+{
+	int i;
+
+	*total = (HIGH_MEMORY - LOW_MEM) >> 12;
+	*free = *shared = *reserved = 0;
+	for (i = 0; i < *total; i++)
+		if (!mem_map[i])
+			(*free)++;
+		else if (mem_map[i] == USED)
+			(*reserved)++;
+		else if (mem_map[i] > 1)
+			(*shared)++;
+}
+
+// 统计线性地址 from 开始 size 字节范围内存在的页面数，跳过不存在的页表
+unsigned long count_pages(unsigned long from, unsigned long size)
+{
+	unsigned long *dir, *pg_table, n = 0;
+	int i;
+
+	dir = (unsigned long *)((from >> 20) & 0xffc);
+	size = (size + 0x3fffff) >> 22;
+	for (; size-- > 0; dir++)
+	{
+		if (!(1 & *dir))
+			continue;
+		pg_table = (unsigned long *)(0xfffff000 & *dir);
+		for (i = 0; i < 1024; i++)
+			if (pg_table[i] & 1)
+				n++;
+	}
+	return n;
+}
+
 // 计算内存空闲页面数并显示
 void calc_mem(void)
 {
@@ -0,0 +1,209 @@
+/*
+ *  linux/mm/mmap.c
+ */
+
+// 文件映射 mmap() / munmap() 系统调用
+// 映射区只记录在进程的 mmap[] 表中，建立时并不分配任何页面
+// 页面是在缺页时由 do_no_page() 按需从文件中读入的（与执行文件的按需加载相同），
+// 并且尽量与其它映射了同一文件同一位置的进程共享
+// 共享映射只支持只读方式，私有映射可写，写时复制
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <asm/segment.h>
+
+// 查找当前进程中包含地址 addr 的文件映射区
+// addr 是相对于进程基址的偏移，缺页和写保护异常处理中使用
+struct mmap_struct *find_mmap(unsigned long addr)
+{
+	struct mmap_struct *m;
+
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+		if (m->inode && addr >= m->start && addr < m->end)
+			return m;
+	return NULL;
+}
+
+// 在映射区范围 [MMAP_START, MMAP_END) 中为长度 len 的映射寻找一段空闲地址
+// 返回：空闲地址，没有足够大的空闲区域则返回 0
+static unsigned long get_unmapped_area(unsigned long len)
+{
+	unsigned long addr = MMAP_START;
+	struct mmap_struct *m;
+
+repeat:
+	if (addr + len > MMAP_END)
+		return 0;
+
+	// 若与已有的映射区重叠，则从该映射区的末端开始重新查找
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+		if (m->inode && m->start < addr + len && addr < m->end)
+		{
+			addr = m->end;
+			goto repeat;
+		}
+	return addr;
+}
+
+// 系统调用 mmap()，将文件 fd 从 offset 开始长度为 len 的部分映射到进程空间中
+// 由于参数多于 3 个，用户程序通过 mmap_arg_struct 结构指针 arg 传递参数
+// 返回：映射区的起始地址；出错则返回出错码
+int sys_mmap(struct mmap_arg_struct *arg)
+{
+	struct mmap_arg_struct a;
+	struct mmap_struct *m, *free = NULL;
+	struct file *file;
+	struct m_inode *inode;
+	unsigned long addr, len;
+	int i;
+
+	// 从用户空间复制参数
+	for (i = 0; i < sizeof(a) / 4; i++)
+		((unsigned long *)&a)[i] = get_fs_long(((unsigned long *)arg) + i);
+
+	// 长度按页面取整，文件偏移必须以页面为边界
+	len = PAGE_ALIGN(a.len);
+	if (!len || len > MMAP_END - MMAP_START || (a.offset & 0xfff))
+		return -EINVAL;
+
+	// 只能映射以可读方式打开的普通文件
+	if (a.fd >= NR_OPEN || !(file = current->filp[a.fd]))
+		return -EBADF;
+	if (!(inode = file->f_inode) || !S_ISREG(inode->i_mode) || inode->i_dev == PROC_DEV)
+		return -ENODEV;
+	if ((file->f_flags & O_ACCMODE) == O_WRONLY)
+		return -EACCES;
+
+	// 存在的页面总是可读的，无法做到不可访问，因此不支持 PROT_NONE
+	if (!(a.prot & (PROT_READ | PROT_WRITE | PROT_EXEC)))
+		return -EINVAL;
+
+	// 共享映射的页面在各进程间共享，并且不会写回文件，因此只能是只读的
+	switch (a.flags & MAP_TYPE)
+	{
+	case MAP_SHARED:
+		if (a.prot & PROT_WRITE)
+			return -EINVAL;
+		break;
+	case MAP_PRIVATE:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	// 在映射区表中找一个空闲项
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+		if (!m->inode)
+		{
+			free = m;
+			break;
+		}
+	if (!free)
+		return -ENOMEM;
+
+	// 若指定了 MAP_FIXED，则地址必须以页面为边界，并且不能与已有的映射区重叠
+	// addr 可能接近 4G，不能用 addr + len 比较，否则会回绕
+	if (a.flags & MAP_FIXED)
+	{
+		addr = a.addr;
+		if ((addr & 0xfff) || addr < MMAP_START || addr > MMAP_END || len > MMAP_END - addr)
+			return -EINVAL;
+		for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+			if (m->inode && m->start < addr + len && addr < m->end)
+				return -EINVAL;
+	}
+	else if (!(addr = get_unmapped_area(len)))
+		return -ENOMEM;
+
+	// 填写映射区表项，并增加文件 i 节点的引用次数。页面在缺页时才读入
+	free->start = addr;
+	free->end = addr + len;
+	free->offset = a.offset;
+	free->prot = a.prot;
+	free->flags = a.flags & MAP_TYPE;
+	free->inode = inode;
+	inode->i_count++;
+	return addr;
+}
+
+// 系统调用 munmap()，撤销地址 addr 开始 len 字节范围内的文件映射
+// 范围可以只覆盖映射区的一部分，此时映射区被截短，或者被分成两个
+int sys_munmap(unsigned long addr, unsigned long len)
+{
+	struct mmap_struct *m, *free = NULL;
+	struct m_inode *inode;
+	unsigned long end, from, to;
+
+	len = PAGE_ALIGN(len);
+	if ((addr & 0xfff) || !len || addr + len < addr)
+		return -EINVAL;
+	end = addr + len;
+
+	// 若要撤销的范围位于某个映射区的中间，则需要一个空闲项来存放分裂出的后半部分
+	// 在做任何修改之前先检查，以免只撤销了一部分
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+		if (!m->inode)
+			free = m;
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+		if (m->inode && m->start < addr && end < m->end && !free)
+			return -ENOMEM;
+
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+	{
+		if (!m->inode || m->end <= addr || end <= m->start)
+			continue;
+
+		// 释放重叠部分已经映射的页面
+		from = (m->start > addr) ? m->start : addr;
+		to = (m->end < end) ? m->end : end;
+		free_page_range(current->start_code + from, to - from);
+
+		if (from == m->start && to == m->end)
+		{
+			// 整个映射区被撤销，放回 i 节点
+			inode = m->inode;
+			m->inode = NULL;
+			iput(inode);
+		}
+		else if (from == m->start)
+		{
+			// 撤销映射区的前半部分
+			m->offset += to - m->start;
+			m->start = to;
+		}
+		else if (to == m->end)
+			// 撤销映射区的后半部分
+			m->end = from;
+		else
+		{
+			// 撤销映射区的中间部分，后半部分放到空闲项中
+			*free = *m;
+			free->offset += to - m->start;
+			free->start = to;
+			m->end = from;
+			m->inode->i_count++;
+		}
+	}
+	return 0;
+}
+
+// 撤销当前进程的所有文件映射区
+// 页面由调用者通过 free_page_tables() 释放，这里只需放回 i 节点
+void exit_mmap(void)
+{
+	struct mmap_struct *m;
+	struct m_inode *inode;
+
+	for (m = current->mmap; m < current->mmap + NR_MMAP; m++)
+		if ((inode = m->inode))
+		{
+			m->inode = NULL;
+			iput(inode);
+		}
+}
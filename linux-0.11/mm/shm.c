@@ -0,0 +1,240 @@
+/*
+ *  linux/mm/shm.c
+ */
+
+// 共享内存段 shmget() / shmat() / shmdt() / shmctl() 系统调用
+// 共享内存段的页面在建立时就全部分配，段本身持有每个页面的一次引用
+// 附加（shmat）时用 put_shared_page() 把同一组物理页面映射到进程的附加槽中，每映射一次页面引用次数加 1，
+// 分离、exit() 和 execve() 时由 free_page_range()/free_page_tables() 撤销映射并递减引用次数，
+// 因此段被删除（IPC_RMID）并且最后一个进程分离之后，段释放自己的引用，页面才真正空闲
+// 共享内存段的页面在 fork() 之后与其它页面一样被置为只读，写保护异常中对它们只恢复可写而不复制
+
+#include <errno.h>
+#include <sys/shm.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+
+// 系统中共享内存段的个数
+#define NR_SHM 16
+
+// 共享内存段
+static struct shm_struct
+{
+	unsigned long size;	 // 段长度（字节，页面的整数倍），为 0 表示该项空闲
+	key_t key;			 // 键值
+	int nattch;			 // 附加该段的次数
+	int removed;		 // 已被删除，最后一次分离后释放
+	unsigned short uid;	 // 建立者的有效用户号
+	unsigned short gid;	 // 建立者的有效组号
+	unsigned short mode; // 访问权限，shmget() 建立时 shmflg 的低 9 位
+	unsigned long page[SHMMAX / PAGE_SIZE]; // 段的物理页面
+} shm_segs[NR_SHM];
+
+// 释放共享内存段的页面（段自己持有的引用），并使该项空闲
+static void free_shm(struct shm_struct *shp)
+{
+	int i;
+
+	for (i = 0; i < shp->size / PAGE_SIZE; i++)
+		free_page(shp->page[i]);
+	shp->size = 0;
+	shp->removed = 0;
+}
+
+// 减少共享内存段 id 的附加计数，已删除的段在最后一次分离后被释放
+static void shm_detach(int id)
+{
+	struct shm_struct *shp = shm_segs + id;
+
+	if (!--shp->nattch && shp->removed)
+		free_shm(shp);
+}
+
+// 检查当前进程对共享内存段的访问权限，mask 是 4（读）、2（写）的组合，与文件的权限位相同
+// 返回：1 - 允许；0 - 不允许
+static int shm_permission(struct shm_struct *shp, int mask)
+{
+	int mode = shp->mode;
+
+	if (suser())
+		return 1;
+	if (current->euid == shp->uid)
+		mode >>= 6;
+	else if (current->egid == shp->gid)
+		mode >>= 3;
+	return (mode & mask & 7) == mask;
+}
+
+// 判断当前进程的地址 addr 是否位于附加的共享内存段中
+// addr 是相对于进程基址的偏移，写保护异常处理中使用
+int find_shm(unsigned long addr)
+{
+	int k;
+
+	if (addr < SHM_START || addr >= SHM_START + NR_SHM_ATTACH * SHMMAX)
+		return 0;
+	k = (addr - SHM_START) / SHMMAX;
+	return current->shm[k] &&
+		   addr - (SHM_START + k * SHMMAX) < shm_segs[current->shm[k] - 1].size;
+}
+
+// 系统调用 shmget()，取键值为 key 的共享内存段，需要时建立长度为 size 字节的新段
+// 返回：共享内存段标识符，出错则返回出错码
+int sys_shmget(key_t key, int size, int shmflg)
+{
+	struct shm_struct *shp, *free = NULL;
+	int i;
+
+	// 查找键值相同的已有段，已删除的段不再能被找到
+	for (shp = shm_segs; shp < shm_segs + NR_SHM; shp++)
+	{
+		if (!shp->size)
+		{
+			if (!free)
+				free = shp;
+			continue;
+		}
+		if (key == IPC_PRIVATE || shp->key != key || shp->removed)
+			continue;
+		if ((shmflg & IPC_CREAT) && (shmflg & IPC_EXCL))
+			return -EEXIST;
+		if (size > shp->size)
+			return -EINVAL;
+		return shp - shm_segs;
+	}
+	if (key != IPC_PRIVATE && !(shmflg & IPC_CREAT))
+		return -ENOENT;
+	if (size <= 0 || size > SHMMAX)
+		return -EINVAL;
+	if (!free)
+		return -ENOSPC;
+
+	// 建立新段，一次分配全部页面。get_free_page() 取得的页面已经清零
+	size = PAGE_ALIGN(size);
+	for (i = 0; i < size / PAGE_SIZE; i++)
+		if (!(free->page[i] = get_free_page()))
+		{
+			while (--i >= 0)
+				free_page(free->page[i]);
+			return -ENOMEM;
+		}
+	free->size = size;
+	free->key = key;
+	free->nattch = 0;
+	free->removed = 0;
+	free->uid = current->euid;
+	free->gid = current->egid;
+	free->mode = shmflg & 0777;
+	return free - shm_segs;
+}
+
+// 系统调用 shmat()，把共享内存段 shmid 附加到当前进程的地址空间中
+// shmaddr 为 0 时使用第一个空闲的附加槽，否则必须是某个空闲附加槽的起始地址
+// 返回：段在进程中的起始地址，出错则返回出错码
+int sys_shmat(int shmid, char *shmaddr, int shmflg)
+{
+	struct shm_struct *shp;
+	unsigned long addr, base;
+	int i, k;
+
+	if (shmid < 0 || shmid >= NR_SHM || !(shp = shm_segs + shmid)->size || shp->removed)
+		return -EINVAL;
+
+	// 段总是以可读写方式附加，需要读和写两种权限
+	if (!shm_permission(shp, 6))
+		return -EACCES;
+
+	// 取附加槽
+	if (shmaddr)
+	{
+		addr = (unsigned long)shmaddr;
+		if (addr < SHM_START || (addr - SHM_START) % SHMMAX)
+			return -EINVAL;
+		k = (addr - SHM_START) / SHMMAX;
+		if (k >= NR_SHM_ATTACH || current->shm[k])
+			return -EINVAL;
+	}
+	else
+	{
+		for (k = 0; k < NR_SHM_ATTACH && current->shm[k]; k++)
+			;
+		if (k >= NR_SHM_ATTACH)
+			return -EMFILE;
+		addr = SHM_START + k * SHMMAX;
+	}
+
+	// 先撤销槽中原有的页面（附加前对该范围的访问会得到普通的空页面），再映射段的各页面
+	base = current->start_code + addr;
+	free_page_range(base, SHMMAX);
+	for (i = 0; i < shp->size / PAGE_SIZE; i++)
+		if (!put_shared_page(shp->page[i], base + i * PAGE_SIZE))
+		{
+			free_page_range(base, SHMMAX);
+			return -ENOMEM;
+		}
+	current->shm[k] = shmid + 1;
+	shp->nattch++;
+	return addr;
+}
+
+// 系统调用 shmdt()，分离附加在地址 shmaddr 处的共享内存段
+int sys_shmdt(char *shmaddr)
+{
+	unsigned long addr = (unsigned long)shmaddr;
+	int k;
+
+	if (addr < SHM_START || (addr - SHM_START) % SHMMAX)
+		return -EINVAL;
+	k = (addr - SHM_START) / SHMMAX;
+	if (k >= NR_SHM_ATTACH || !current->shm[k])
+		return -EINVAL;
+	free_page_range(current->start_code + addr, SHMMAX);
+	shm_detach(current->shm[k] - 1);
+	current->shm[k] = 0;
+	return 0;
+}
+
+// 系统调用 shmctl()，目前只支持 IPC_RMID：删除共享内存段
+// 段的页面在最后一个进程分离之后才被释放，已附加的进程仍可继续使用
+int sys_shmctl(int shmid, int cmd, void *buf)
+{
+	struct shm_struct *shp;
+
+	if (shmid < 0 || shmid >= NR_SHM || !(shp = shm_segs + shmid)->size || shp->removed)
+		return -EINVAL;
+	if (cmd != IPC_RMID)
+		return -EINVAL;
+
+	// 只有建立者和超级用户可以删除段
+	if (!suser() && current->euid != shp->uid)
+		return -EPERM;
+	shp->removed = 1;
+	if (!shp->nattch)
+		free_shm(shp);
+	return 0;
+}
+
+// 子进程 p 继承父进程附加的共享内存段，页面映射已由 copy_page_tables() 复制
+void fork_shm(struct task_struct *p)
+{
+	int k;
+
+	for (k = 0; k < NR_SHM_ATTACH; k++)
+		if (p->shm[k])
+			shm_segs[p->shm[k] - 1].nattch++;
+}
+
+// 分离当前进程附加的所有共享内存段，页面映射由调用者通过 free_page_tables() 撤销
+void exit_shm(void)
+{
+	int k;
+
+	for (k = 0; k < NR_SHM_ATTACH; k++)
+		if (current->shm[k])
+		{
+			shm_detach(current->shm[k] - 1);
+			current->shm[k] = 0;
+		}
+}
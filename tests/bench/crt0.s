@@ -0,0 +1,11 @@
+# 基准测试程序的启动代码
+# execve() 在用户栈顶依次放好 envp、argv 和 argc（见 fs/exec.c 中的 create_tables()），
+# 正好是 main(argc, argv, envp) 的参数，main() 返回后以返回值调用 _exit()
+
+.text
+.globl _start
+_start:
+	call main
+	pushl %eax
+	call _exit
+1:	jmp 1b
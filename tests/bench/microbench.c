@@ -0,0 +1,408 @@
+/*
+ * 系统调用微基准测试
+ *
+ * 由 makefile 交叉编译，放在测试硬盘映像中作为 /bin/sh：init 以 /etc/rc 为标准输入执行它，
+ * 它按 /etc/rc 中的列表依次运行各项测试，结果写到控制台和串口终端 /dev/tty1（QEMU 把串口输出到文件），
+ * 全部完成后输出 "BENCH END" 并停在 pause() 中。见 run.sh
+ *
+ * /etc/rc 每行一项：测试名 [次数]，# 开头的行是注释。以 / 开头的测试名是另一个测试程序（如 /bin/pipebench），
+ * 以给出的次数为参数执行它并等待它结束，它自己输出 RESULT 行。也可以在 Linux 0.11 中直接运行：
+ *
+ *     microbench [测试名 [次数]] ...
+ *
+ * 每项测试输出一行，便于程序解析：
+ *
+ *     RESULT name=<测试名> iters=<次数> ticks=<滴答数> ops_per_sec=<每秒操作数> kb_per_sec=<每秒千字节数>
+ *
+ * 时间用 times() 的返回值（滴答数，HZ = 100）计算，次数应足够多，使每项测试至少持续几秒
+ */
+
+#include "ulib.h"
+
+#define TMP_FILE "/tmp/bench.dat"
+#define LOOKUP_DIR "/tmp/d1/d2/d3"
+#define LOOKUP_FILE "/tmp/d1/d2/d3/file"
+#define CREAT_FILE "/tmp/creat.tmp"
+
+// 上下文切换测试中令牌环上的进程数
+#define NR_RING 4
+
+static char buf[65536];
+
+// 等待子进程 pid 退出
+// 返回：子进程正常退出且退出码为 0 时返回 0，否则返回 -1
+static int reap(int pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) != pid)
+		return -1;
+	return status ? -1 : 0;
+}
+
+// fork() 一个立即退出的子进程，并等待它
+static long bench_fork_exit(long n, long arg)
+{
+	long i;
+	int pid;
+
+	for (i = 0; i < n; i++)
+	{
+		if (!(pid = fork()))
+			_exit(0);
+		if (pid < 0 || reap(pid))
+			return -1;
+	}
+	return n;
+}
+
+// fork() 一个子进程执行 /bin/true，并等待它
+static long bench_fork_exec(long n, long arg)
+{
+	static char *argv[] = {"true", 0};
+	static char *envp[] = {0};
+	long i;
+	int pid;
+
+	for (i = 0; i < n; i++)
+	{
+		if (!(pid = fork()))
+		{
+			execve("/bin/true", argv, envp);
+			_exit(127);
+		}
+		if (pid < 0 || reap(pid))
+			return -1;
+	}
+	return n;
+}
+
+// 父子进程通过两个管道来回传递一个字节，每次往返是一次操作
+static long bench_pipe_pingpong(long n, long arg)
+{
+	int to[2], from[2], pid;
+	long i;
+	char c = 0;
+
+	if (pipe(to) < 0 || pipe(from) < 0)
+		return -1;
+	if (!(pid = fork()))
+	{
+		close(to[1]);
+		close(from[0]);
+		while (read(to[0], &c, 1) == 1)
+			write(from[1], &c, 1);
+		_exit(0);
+	}
+	close(to[0]);
+	close(from[1]);
+	for (i = 0; i < n && pid > 0; i++)
+		if (write(to[1], &c, 1) != 1 || read(from[0], &c, 1) != 1)
+			break;
+	close(to[1]);
+	close(from[0]);
+	if (pid < 0 || reap(pid) || i < n)
+		return -1;
+	return n;
+}
+
+// NR_RING 个进程用管道连成一个环，依次传递一个字节的令牌，每传递一次是一次进程切换
+// 进程 k 从 ring[k] 读出令牌，写入 ring[(k + 1) % NR_RING]；进程 0 是父进程
+static long bench_ctxsw(long n, long arg)
+{
+	int ring[NR_RING][2], pid[NR_RING];
+	int k, j, err = 0;
+	long i;
+	char c = 0;
+
+	for (k = 0; k < NR_RING; k++)
+		if (pipe(ring[k]) < 0)
+			return -1;
+	for (k = 1; k < NR_RING; k++)
+		if (!(pid[k] = fork()))
+		{
+			// 只留下自己读的一端和写的一端，上游关闭后读到文件结尾，退出时再关闭下游
+			for (j = 0; j < NR_RING; j++)
+			{
+				if (j != k)
+					close(ring[j][0]);
+				if (j != (k + 1) % NR_RING)
+					close(ring[j][1]);
+			}
+			while (read(ring[k][0], &c, 1) == 1)
+				write(ring[(k + 1) % NR_RING][1], &c, 1);
+			_exit(0);
+		}
+		else if (pid[k] < 0)
+			err = 1;
+	for (j = 0; j < NR_RING; j++)
+	{
+		if (j != 0)
+			close(ring[j][0]);
+		if (j != 1)
+			close(ring[j][1]);
+	}
+	for (i = 0; i < n && !err; i++)
+		if (write(ring[1][1], &c, 1) != 1 || read(ring[0][0], &c, 1) != 1)
+			err = 1;
+	close(ring[1][1]);
+	close(ring[0][0]);
+	for (k = 1; k < NR_RING; k++)
+		if (pid[k] > 0 && reap(pid[k]))
+			err = 1;
+	return err ? -1 : n * NR_RING;
+}
+
+// 重复从文件开头写入 size 字节
+static long bench_write(long n, long size)
+{
+	int fd;
+	long i;
+
+	if ((fd = creat(TMP_FILE, 0644)) < 0)
+		return -1;
+	for (i = 0; i < n; i++)
+		if (lseek(fd, 0, 0) != 0 || write(fd, buf, size) != size)
+			break;
+	close(fd);
+	return i < n ? -1 : n;
+}
+
+// 重复从文件开头读出 size 字节，文件先在计时之前写好（见 prepare_read()）
+static long bench_read(long n, long size)
+{
+	int fd;
+	long i;
+
+	if ((fd = open(TMP_FILE, O_RDONLY, 0)) < 0)
+		return -1;
+	for (i = 0; i < n; i++)
+		if (lseek(fd, 0, 0) != 0 || read(fd, buf, size) != size)
+			break;
+	close(fd);
+	return i < n ? -1 : n;
+}
+
+static int prepare_read(long size)
+{
+	return bench_write(1, size) < 0 ? -1 : 0;
+}
+
+// 路径名查找：stat() 一个 4 层目录下的文件
+static long bench_stat(long n, long arg)
+{
+	struct stat st;
+	long i;
+
+	for (i = 0; i < n; i++)
+		if (stat(LOOKUP_FILE, &st) < 0)
+			return -1;
+	return n;
+}
+
+// 路径名查找：打开并关闭一个 4 层目录下的文件
+static long bench_open_close(long n, long arg)
+{
+	long i;
+	int fd;
+
+	for (i = 0; i < n; i++)
+	{
+		if ((fd = open(LOOKUP_FILE, O_RDONLY, 0)) < 0)
+			return -1;
+		close(fd);
+	}
+	return n;
+}
+
+static int prepare_lookup(long arg)
+{
+	int fd;
+
+	mkdir("/tmp/d1", 0755);
+	mkdir("/tmp/d1/d2", 0755);
+	mkdir(LOOKUP_DIR, 0755);
+	if ((fd = creat(LOOKUP_FILE, 0644)) < 0)
+		return -1;
+	close(fd);
+	return 0;
+}
+
+// 建立一个空文件再删除
+static long bench_creat_unlink(long n, long arg)
+{
+	long i;
+	int fd;
+
+	for (i = 0; i < n; i++)
+	{
+		if ((fd = creat(CREAT_FILE, 0644)) < 0)
+			return -1;
+		close(fd);
+		if (unlink(CREAT_FILE) < 0)
+			return -1;
+	}
+	return n;
+}
+
+static struct bench
+{
+	const char *name;
+	long (*fn)(long n, long arg);
+	int (*prepare)(long arg); // 计时之前的准备，可以为空
+	long arg;				  // 传给 fn 和 prepare 的参数：读写测试中是每次读写的字节数
+	long iters;				  // 默认次数
+} benches[] = {
+	{"fork_exit", bench_fork_exit, 0, 0, 1000},
+	{"fork_exec", bench_fork_exec, 0, 0, 500},
+	{"pipe_pingpong", bench_pipe_pingpong, 0, 0, 10000},
+	{"ctxsw", bench_ctxsw, 0, 0, 5000},
+	{"write_1k", bench_write, 0, 1024, 20000},
+	{"read_1k", bench_read, prepare_read, 1024, 20000},
+	{"write_64k", bench_write, 0, 65536, 500},
+	{"read_64k", bench_read, prepare_read, 65536, 500},
+	{"stat", bench_stat, prepare_lookup, 0, 10000},
+	{"open_close", bench_open_close, prepare_lookup, 0, 10000},
+	{"creat_unlink", bench_creat_unlink, 0, 0, 2000},
+	{0}};
+
+// 运行测试 name，iters 为 0 时使用默认次数
+static void run(const char *name, long iters)
+{
+	struct bench *b;
+	struct tms tms;
+	long start, ticks = 0, ops;
+
+	for (b = benches; b->name; b++)
+		if (ueq(b->name, name))
+			break;
+	if (!b->name)
+	{
+		say("ERROR unknown benchmark ");
+		say(name);
+		say("\n");
+		return;
+	}
+	if (iters <= 0)
+		iters = b->iters;
+	if (b->prepare && b->prepare(b->arg) < 0)
+		ops = -1;
+	else
+	{
+		start = times(&tms);
+		ops = b->fn(iters, b->arg);
+		ticks = times(&tms) - start;
+	}
+	if (ops < 0)
+	{
+		say("ERROR ");
+		say(name);
+		say(" failed\n");
+		return;
+	}
+	say_result(name, iters, ticks, ops, iters * (b->arg / 1024));
+}
+
+// 运行测试程序 path，arg 不为空时作为它的参数。程序自己输出 RESULT 行
+static void run_prog(const char *path, char *arg)
+{
+	char *argv[] = {(char *)path, arg, 0};
+	static char *envp[] = {0};
+	int pid;
+
+	if (!*arg)
+		argv[1] = 0;
+	if (!(pid = fork()))
+	{
+		execve(path, argv, envp);
+		_exit(127);
+	}
+	if (pid < 0 || reap(pid))
+	{
+		say("ERROR ");
+		say(path);
+		say(" failed\n");
+	}
+}
+
+// 以 / 开头的名字是测试程序的路径名，否则是本程序中的一项测试
+static void run_one(const char *name, char *arg)
+{
+	if (*name == '/')
+		run_prog(name, arg);
+	else
+		run(name, uatol(arg));
+}
+
+// 按 /etc/rc（标准输入）中的列表运行测试
+static void run_list(void)
+{
+	static char rc[4096];
+	char *p, *name, *arg;
+	int n, len = 0;
+
+	while (len < sizeof(rc) - 1 && (n = read(0, rc + len, sizeof(rc) - 1 - len)) > 0)
+		len += n;
+	rc[len > 0 ? len : 0] = 0;
+	for (p = rc; *p;)
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '#' || *p == '\n' || !*p)
+		{
+			while (*p && *p++ != '\n')
+				;
+			continue;
+		}
+		name = p;
+		while (*p && *p != ' ' && *p != '\t' && *p != '\n')
+			p++;
+		if (*p != '\n' && *p)
+		{
+			*p++ = 0;
+			while (*p == ' ' || *p == '\t')
+				p++;
+		}
+		arg = p;
+		while (*p && *p != ' ' && *p != '\t' && *p != '\n')
+			p++;
+		if (*p != '\n' && *p) // 参数后面的内容忽略
+		{
+			*p++ = 0;
+			while (*p && *p != '\n')
+				p++;
+		}
+		if (*p)
+			*p++ = 0;
+		run_one(name, arg);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	say_open();
+	say("BENCH START\n");
+	if (argc > 1)
+	{
+		for (i = 1; i < argc; i++)
+			if (i + 1 < argc && *argv[i + 1] >= '0' && *argv[i + 1] <= '9')
+			{
+				run_one(argv[i], argv[i + 1]);
+				i++;
+			}
+			else
+				run_one(argv[i], "");
+	}
+	else
+		run_list();
+	say("BENCH END\n");
+	sync();
+
+	// 作为 init 启动的 /bin/sh 运行时不退出，否则 init 会再启动一个 /bin/sh
+	if (ueq(argv[0], "/bin/sh"))
+		for (;;)
+			pause();
+	return 0;
+}
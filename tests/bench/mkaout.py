@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+#
+# 把用 aout.ld 连接出来的 ELF 文件转换成 Linux 0.11 能执行的 ZMAGIC 格式 a.out 文件
+#
+#     mkaout.py prog.elf prog
+#
+# 文件开头是 1024 字节的头部（struct exec，见 include/a.out.h，其余填 0），
+# 之后是代码段（长度补齐到页）和数据段，bss 只在头部中记录长度
+
+import os
+import struct
+import sys
+
+ZMAGIC = 0o413
+PAGE = 4096
+
+
+def sections(elf):
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        sys.exit('not a 32-bit ELF file')
+    shoff, = struct.unpack_from('<I', elf, 32)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 46)
+    hdrs = [struct.unpack_from('<IIIIIIIIII', elf, shoff + i * shentsize)
+            for i in range(shnum)]
+    strtab = hdrs[shstrndx][4]
+    result = {}
+    for name, type_, flags, addr, offset, size, *_ in hdrs:
+        end = elf.index(b'\0', strtab + name)
+        result[elf[strtab + name:end].decode()] = (type_, addr, offset, size)
+    return result
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: mkaout.py prog.elf prog')
+    elf = open(sys.argv[1], 'rb').read()
+    sec = sections(elf)
+    entry, = struct.unpack_from('<I', elf, 24)
+
+    text = sec['.text']
+    if text[1] != 0:
+        sys.exit('.text must start at address 0')
+    a_text = (text[3] + PAGE - 1) & ~(PAGE - 1)
+    data = sec.get('.data', (1, a_text, 0, 0))
+    bss = sec.get('.bss', (8, data[1] + data[3], 0, 0))
+    if data[3] and data[1] != a_text:
+        sys.exit('.data must follow the page aligned .text')
+    a_data = data[3]
+    a_bss = bss[1] + bss[3] - (a_text + a_data) if bss[3] else 0
+
+    image = bytearray(1024 + a_text + a_data)
+    struct.pack_into('<8I', image, 0, ZMAGIC, a_text, a_data, a_bss,
+                     0, entry, 0, 0)
+    image[1024:1024 + text[3]] = elf[text[2]:text[2] + text[3]]
+    if a_data:
+        image[1024 + a_text:] = elf[data[2]:data[2] + a_data]
+    open(sys.argv[2], 'wb').write(image)
+    # mkhd.py 照搬文件的权限位，do_execve() 要求有执行权限
+    os.chmod(sys.argv[2], 0o755)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+#
+# 生成基准测试用的硬盘映像：一个分区表，第 1 个分区是 MINIX 1.0 文件系统（1KB 块，14 字符文件名），
+# 内容取自宿主机上的目录 root，另外建立 /dev 中的设备文件。内核默认的根设备 /dev/hd1 就是这个分区
+# 不需要 mount 权限，也不依赖 mkfs.minix
+#
+#     mkhd.py hda.img root [MB]
+#
+# 磁盘几何参数取 16 个磁头、每磁道 63 扇区，分区从第 1 个磁道开始，QEMU 会按分区表推算出同样的参数
+
+import os
+import stat
+import struct
+import sys
+import time
+
+BLOCK = 1024
+HEADS, SECTORS = 16, 63
+MINIX_MAGIC = 0x137f
+NAME_LEN = 14
+
+# 设备文件：名字、类型、主设备号、次设备号
+DEVICES = [
+    ('tty', stat.S_IFCHR, 5, 0),
+    ('tty0', stat.S_IFCHR, 4, 0),
+    ('tty1', stat.S_IFCHR, 4, 1),
+    ('tty2', stat.S_IFCHR, 4, 2),
+    ('null', stat.S_IFCHR, 1, 3),
+    ('trace', stat.S_IFCHR, 1, 6),
+    ('blkstat', stat.S_IFCHR, 1, 8),
+    ('hd0', stat.S_IFBLK, 3, 0),
+    ('hd1', stat.S_IFBLK, 3, 1),
+    ('proc', stat.S_IFBLK, 0, 1),
+]
+
+
+class MinixFS:
+    def __init__(self, nblocks):
+        self.nzones = nblocks
+        self.ninodes = min(nblocks // 3, 65535) & ~31
+        self.imap_blocks = (self.ninodes + 1 + 8191) // 8192
+        self.zmap_blocks = (self.nzones + 8191) // 8192
+        self.inode_blocks = (self.ninodes * 32 + BLOCK - 1) // BLOCK
+        self.firstdatazone = 2 + self.imap_blocks + self.zmap_blocks + self.inode_blocks
+        self.disk = bytearray(nblocks * BLOCK)
+        self.inodes = {}                    # i 节点号 -> [mode, uid, size, time, gid, nlinks, zones]
+        self.next_inode = 1
+        self.next_zone = self.firstdatazone
+        self.now = int(time.time())
+
+    def alloc_zone(self):
+        if self.next_zone >= self.nzones:
+            sys.exit('disk image full')
+        self.next_zone += 1
+        return self.next_zone - 1
+
+    def new_inode(self, mode, nlinks=1):
+        if self.next_inode > self.ninodes:
+            sys.exit('out of inodes')
+        ino = self.next_inode
+        self.next_inode += 1
+        self.inodes[ino] = [mode, 0, 0, self.now, 0, nlinks, [0] * 9]
+        return ino
+
+    # 把 data 写成 i 节点 ino 的内容：7 个直接块，超过时用一次间接块
+    def write_data(self, ino, data):
+        zones = self.inodes[ino][6]
+        nblk = (len(data) + BLOCK - 1) // BLOCK
+        if nblk > 7 + BLOCK // 2:
+            sys.exit('file too large')
+        blocks = []
+        for i in range(nblk):
+            z = self.alloc_zone()
+            chunk = data[i * BLOCK:(i + 1) * BLOCK]
+            self.disk[z * BLOCK:z * BLOCK + len(chunk)] = chunk
+            blocks.append(z)
+        zones[:min(nblk, 7)] = blocks[:7]
+        if nblk > 7:
+            zones[7] = ind = self.alloc_zone()
+            struct.pack_into('<%dH' % (nblk - 7), self.disk, ind * BLOCK, *blocks[7:])
+        self.inodes[ino][2] = len(data)
+
+    def add_dir(self, parent):
+        ino = self.new_inode(stat.S_IFDIR | 0o755, 2)
+        self.dirs[ino] = [('.', ino), ('..', parent or ino)]
+        return ino
+
+    def build(self, root):
+        self.dirs = {}
+        root_ino = self.add_dir(0)
+        self.fill(root_ino, root)
+        dev = self.lookup_dir(root_ino, 'dev')
+        for name, kind, major, minor in DEVICES:
+            ino = self.new_inode(kind | 0o666)
+            self.inodes[ino][6][0] = major << 8 | minor
+            self.dirs[dev].append((name, ino))
+        for d in ('tmp', 'mnt', 'proc'):
+            self.lookup_dir(root_ino, d)
+        for ino, entries in self.dirs.items():
+            data = bytearray()
+            for name, child in entries:
+                data += struct.pack('<H', child) + name.encode()[:NAME_LEN].ljust(NAME_LEN, b'\0')
+            self.write_data(ino, bytes(data))
+        tmp = self.lookup_dir(root_ino, 'tmp')
+        self.inodes[tmp][0] = stat.S_IFDIR | 0o1777
+
+    def lookup_dir(self, parent, name):
+        for n, ino in self.dirs[parent]:
+            if n == name and ino in self.dirs:
+                return ino
+        ino = self.add_dir(parent)
+        self.dirs[parent].append((name, ino))
+        self.inodes[parent][5] += 1
+        return ino
+
+    def fill(self, dir_ino, path):
+        for name in sorted(os.listdir(path)):
+            full = os.path.join(path, name)
+            st = os.lstat(full)
+            if stat.S_ISDIR(st.st_mode):
+                self.fill(self.lookup_dir(dir_ino, name), full)
+            elif stat.S_ISREG(st.st_mode):
+                ino = self.new_inode(stat.S_IFREG | (st.st_mode & 0o777))
+                self.write_data(ino, open(full, 'rb').read())
+                self.dirs[dir_ino].append((name, ino))
+
+    # 写超级块、i 节点位图、逻辑块位图和 i 节点表
+    def finish(self):
+        max_size = (7 + 512 + 512 * 512) * BLOCK
+        struct.pack_into('<6HIHH', self.disk, BLOCK, self.ninodes, self.nzones,
+                         self.imap_blocks, self.zmap_blocks, self.firstdatazone,
+                         0, max_size, MINIX_MAGIC, 1)
+        imap = 2 * BLOCK
+        zmap = imap + self.imap_blocks * BLOCK
+        itab = zmap + self.zmap_blocks * BLOCK
+        # 位图的第 0 位不用；已用的 i 节点和逻辑块，以及超出范围的位都置 1
+        used_inodes = self.next_inode
+        for bit in range(self.imap_blocks * BLOCK * 8):
+            if bit < used_inodes or bit > self.ninodes:
+                self.disk[imap + bit // 8] |= 1 << (bit % 8)
+        used_zones = self.next_zone - self.firstdatazone + 1
+        for bit in range(self.zmap_blocks * BLOCK * 8):
+            if bit < used_zones or bit + self.firstdatazone - 1 >= self.nzones:
+                self.disk[zmap + bit // 8] |= 1 << (bit % 8)
+        for ino, (mode, uid, size, mtime, gid, nlinks, zones) in self.inodes.items():
+            struct.pack_into('<HHIIBB9H', self.disk, itab + (ino - 1) * 32,
+                             mode, uid, size, mtime, gid, nlinks, *zones)
+
+
+def chs(lba):
+    c = lba // (HEADS * SECTORS)
+    h = lba // SECTORS % HEADS
+    s = lba % SECTORS + 1
+    return bytes([h, s | (c >> 2 & 0xc0), c & 0xff])
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit('usage: mkhd.py hda.img root [MB]')
+    mb = int(sys.argv[3]) if len(sys.argv) == 4 else 8
+    if not 1 <= mb <= 60:
+        sys.exit('size must be 1..60 MB')
+    cyls = mb * 1024 * 1024 // (HEADS * SECTORS * 512)
+    total = cyls * HEADS * SECTORS
+    start = SECTORS
+    nsects = (total - start) & ~1
+
+    fs = MinixFS(nsects // 2)
+    fs.build(sys.argv[2])
+    fs.finish()
+
+    mbr = bytearray(512)
+    mbr[446:462] = (b'\0' + chs(start) + b'\x81' + chs(start + nsects - 1)
+                    + struct.pack('<II', start, nsects))
+    mbr[510:512] = b'\x55\xaa'
+    with open(sys.argv[1], 'wb') as f:
+        f.write(mbr)
+        f.write(bytes((start - 1) * 512))
+        f.write(fs.disk)
+        f.write(bytes((total - start - nsects) * 512))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,90 @@
+/*
+ * 管道吞吐量测试
+ *
+ * 由 makefile 交叉编译，放在测试硬盘映像中作为 /bin/pipebench，由 microbench 按 /etc/rc 运行：
+ *
+ *     pipebench [MB]
+ *
+ * 子进程向管道写入 MB（默认 4）兆字节的数据，父进程读出，
+ * 分别在不同的管道缓冲区大小（1、2、4、8 页）和每次读写的字节数下测量吞吐量。
+ * 每种组合输出一行 RESULT（格式见 microbench.c），测试名为 pipe_<缓冲区千字节数>k_<每次读写的字节数>，
+ * 次数是写的次数
+ */
+
+#include "ulib.h"
+
+static char buf[16384];
+
+// 以每次 chunk 字节的读写，通过缓冲区为 pipe_size 字节的管道传送 total 字节
+// 返回：所用的滴答数，出错返回 -1
+static long run(long total, int pipe_size, int chunk)
+{
+	int fd[2], n, status;
+	long left, start;
+	struct tms tms;
+
+	if (pipe(fd) < 0)
+		return -1;
+	if (fcntl(fd[0], F_SETPIPE_SZ, pipe_size) != pipe_size)
+	{
+		close(fd[0]);
+		close(fd[1]);
+		return -1;
+	}
+
+	start = times(&tms);
+	switch (fork())
+	{
+	case -1:
+		return -1;
+	case 0:
+		close(fd[0]);
+		for (left = total; left > 0; left -= n)
+			if ((n = write(fd[1], buf, left < chunk ? left : chunk)) <= 0)
+				_exit(1);
+		_exit(0);
+	}
+
+	close(fd[1]);
+	for (left = total; left > 0; left -= n)
+		if ((n = read(fd[0], buf, chunk)) <= 0)
+			break;
+	close(fd[0]);
+	wait(&status);
+	if (left > 0 || status)
+		return -1;
+	return times(&tms) - start;
+}
+
+int main(int argc, char **argv)
+{
+	static int pipe_pages[] = {1, 2, 4, 8};
+	static int chunks[] = {512, 4096, 16384};
+	char name[32], num[12], *p;
+	long total, ticks;
+	int i, j, err = 0;
+
+	total = (argc > 1 && uatol(argv[1]) > 0 ? uatol(argv[1]) : 4) * 1024L * 1024L;
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = 'x';
+	say_open();
+
+	for (i = 0; i < sizeof(pipe_pages) / sizeof(pipe_pages[0]); i++)
+		for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++)
+		{
+			p = ucat(name, "pipe_");
+			p = ucat(p, uitoa(pipe_pages[i] * 4, num));
+			p = ucat(p, "k_");
+			ucat(p, uitoa(chunks[j], num));
+			if ((ticks = run(total, pipe_pages[i] * 4096, chunks[j])) < 0)
+			{
+				say("ERROR ");
+				say(name);
+				say(" failed\n");
+				err = 1;
+				continue;
+			}
+			say_result(name, total / chunks[j], ticks, total / chunks[j], total / 1024);
+		}
+	return err;
+}
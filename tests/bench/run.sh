@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# 在 QEMU 中无界面地启动测试映像，等待 microbench 输出 "BENCH END" 后结束 QEMU，
+# 把串口输出中的 RESULT 行整理成 results.txt（每行：测试名 次数 滴答数 每秒操作数 每秒千字节数）
+#
+#     run.sh fda.img hda.img results.txt
+#
+# 环境变量 QEMU 指定模拟器（默认 qemu-system-i386），BENCH_TIMEOUT 指定最长等待的秒数（默认 900）
+
+FDA=${1:-fda.img}
+HDA=${2:-hda.img}
+RESULTS=${3:-results.txt}
+QEMU=${QEMU:-qemu-system-i386}
+TIMEOUT=${BENCH_TIMEOUT:-900}
+LOG=serial.log
+
+rm -f $LOG
+$QEMU -m 16M -boot a -fda $FDA -hda $HDA \
+	-display none -serial file:$LOG -monitor none -no-reboot &
+pid=$!
+
+i=0
+while [ $i -lt $TIMEOUT ]; do
+	if grep -q '^BENCH END' $LOG 2>/dev/null; then
+		break
+	fi
+	if ! kill -0 $pid 2>/dev/null; then
+		break
+	fi
+	sleep 1
+	i=$((i + 1))
+done
+kill $pid 2>/dev/null
+wait $pid 2>/dev/null
+
+tr -d '\r' < $LOG | grep '^ERROR' >&2
+tr -d '\r' < $LOG | sed -n 's/^RESULT name=\([^ ]*\) iters=\([0-9]*\) ticks=\([0-9]*\) ops_per_sec=\([0-9]*\) kb_per_sec=\([0-9]*\).*/\1 \2 \3 \4 \5/p' > $RESULTS
+cat $RESULTS
+
+if ! tr -d '\r' < $LOG | grep -q '^BENCH END'; then
+	echo "run.sh: benchmark did not finish, see $LOG" >&2
+	exit 1
+fi
@@ -0,0 +1,8 @@
+/*
+ * 什么也不做、立即退出的程序，作为 fork_exec 测试中 execve() 的对象
+ */
+
+int main(void)
+{
+	return 0;
+}
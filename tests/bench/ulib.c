@@ -0,0 +1,140 @@
+/*
+ * 基准测试程序用的最小运行库，见 ulib.h
+ */
+
+#include "ulib.h"
+
+_syscall3(int, read, int, fd, char *, buf, off_t, count)
+_syscall2(int, creat, const char *, filename, mode_t, mode)
+_syscall1(int, unlink, const char *, filename)
+_syscall2(int, stat, const char *, filename, struct stat *, stat_buf)
+_syscall1(int, pipe, int *, fildes)
+_syscall1(time_t, times, struct tms *, tbuf)
+_syscall3(int, lseek, int, fildes, off_t, offset, int, origin)
+_syscall2(int, mkdir, const char *, path, mode_t, mode)
+_syscall3(int, socket, int, domain, int, type, int, protocol)
+_syscall3(int, bind, int, fd, struct sockaddr *, addr, int, addrlen)
+_syscall2(int, listen, int, fd, int, backlog)
+_syscall3(int, accept, int, fd, struct sockaddr *, addr, int *, addrlen)
+_syscall3(int, connect, int, fd, struct sockaddr *, addr, int, addrlen)
+
+// fcntl() 的第三个参数可有可无，与 lib/open.c 中的 open() 一样取出后放在 edx 中。
+// 内核的 <stdarg.h> 按栈上的地址取参数，-O2 编译时 gcc 会给出越界警告，这里用编译器内建的版本
+int fcntl(int fildes, int cmd, ...)
+{
+	register int res;
+	__builtin_va_list arg;
+
+	__builtin_va_start(arg, cmd);
+	__asm__("int $0x80"
+			: "=a"(res)
+			: "0"(__NR_fcntl), "b"(fildes), "c"(cmd),
+			  "d"(__builtin_va_arg(arg, long)));
+	__builtin_va_end(arg);
+	if (res >= 0)
+		return res;
+	errno = -res;
+	return -1;
+}
+
+static int out[2] = {1, -1};
+
+int ulen(const char *s)
+{
+	const char *p = s;
+
+	while (*p)
+		p++;
+	return p - s;
+}
+
+int ueq(const char *a, const char *b)
+{
+	while (*a && *a == *b)
+		a++, b++;
+	return *a == *b;
+}
+
+// 十进制字符串转换为整数，遇到非数字字符为止
+long uatol(const char *s)
+{
+	long n = 0;
+
+	while (*s >= '0' && *s <= '9')
+		n = n * 10 + *s++ - '0';
+	return n;
+}
+
+// 整数转换为十进制字符串，buf 至少 12 字节
+// 返回：字符串在 buf 中的起始位置
+char *uitoa(long n, char *buf)
+{
+	char *p = buf + 11;
+	int neg = n < 0;
+
+	*p = 0;
+	if (neg)
+		n = -n;
+	do
+		*--p = '0' + n % 10;
+	while (n /= 10);
+	if (neg)
+		*--p = '-';
+	return p;
+}
+
+// 把 src 复制到 dest
+// 返回：dest 中字符串的结尾，可以接着复制下一段
+char *ucat(char *dest, const char *src)
+{
+	while ((*dest = *src++))
+		dest++;
+	return dest;
+}
+
+void uputs(int fd, const char *s)
+{
+	if (fd >= 0)
+		write(fd, s, ulen(s));
+}
+
+void uputn(int fd, long n)
+{
+	char buf[12];
+
+	uputs(fd, uitoa(n, buf));
+}
+
+void say_open(void)
+{
+	out[1] = open("/dev/tty1", O_WRONLY, 0);
+}
+
+void say(const char *s)
+{
+	uputs(out[0], s);
+	uputs(out[1], s);
+}
+
+void sayn(long n)
+{
+	uputn(out[0], n);
+	uputn(out[1], n);
+}
+
+void say_result(const char *name, long iters, long ticks, long ops, long kb)
+{
+	if (ticks <= 0)
+		ticks = 1;
+	say("RESULT name=");
+	say(name);
+	say(" iters=");
+	sayn(iters);
+	say(" ticks=");
+	sayn(ticks);
+	say(" ops_per_sec=");
+	sayn(ops * HZ / ticks);
+	say(" kb_per_sec=");
+	sayn(kb * HZ / ticks);
+	say("\n");
+}
@@ -0,0 +1,44 @@
+/*
+ * 基准测试程序用的最小运行库
+ *
+ * 这些程序在宿主机上交叉编译，不使用 C 库：系统调用号和 _syscallN 宏直接取自内核的 include/unistd.h，
+ * open()/write()/execve()/waitpid() 等取自内核的 lib/lib.a，其余的系统调用在 ulib.c 中定义
+ */
+
+#ifndef _ULIB_H
+#define _ULIB_H
+
+#define __LIBRARY__
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/times.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+
+#define HZ 100
+
+// unistd.h 把这几个声明成 static（init/main.c 需要内联），因此每个使用它们的文件各有一份
+static inline _syscall0(int, fork)
+static inline _syscall0(int, pause)
+static inline _syscall0(int, sync)
+
+extern int mkdir(const char *path, mode_t mode);
+
+// 字符串和输出
+extern int ulen(const char *s);
+extern int ueq(const char *a, const char *b);
+extern long uatol(const char *s);
+extern char *uitoa(long n, char *buf);
+extern char *ucat(char *dest, const char *src);
+extern void uputs(int fd, const char *s);
+extern void uputn(int fd, long n);
+
+// 测试结果同时输出到标准输出和串口终端 /dev/tty1（QEMU 把串口输出到文件，见 run.sh），先调用 say_open()
+extern void say_open(void);
+extern void say(const char *s);
+extern void sayn(long n);
+// 输出一行 RESULT（格式见 microbench.c），kb 是测试中读写的总千字节数，不读写数据的测试为 0
+extern void say_result(const char *name, long iters, long ticks, long ops, long kb);
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * UNIX 域套接字请求/应答延迟测试
+ *
+ * 由 makefile 交叉编译，放在测试硬盘映像中作为 /bin/unixbench，由 microbench 按 /etc/rc 运行：
+ *
+ *     unixbench [次数]
+ *
+ * 服务进程在 /tmp/unixbench.sock 上监听，客户进程连接后发送请求，服务进程原样返回，
+ * 客户收到完整的应答后再发下一个请求。分别在不同的消息长度下测量往返的次数（默认 2000 次），
+ * 并与一对管道上同样的往返作比较。每项输出一行 RESULT（格式见 microbench.c），
+ * 测试名为 unix_rtt_<消息长度> 和 pipe_rtt_<消息长度>，ops_per_sec 是每秒的往返次数
+ */
+
+#include <sys/un.h>
+#include "ulib.h"
+
+#define SOCK_NAME "/tmp/unixbench.sock"
+
+static char buf[4096];
+
+// 从 fd 读满 count 字节
+// 返回：0 表示成功，对方关闭或出错返回 -1
+static int read_full(int fd, char *p, int count)
+{
+	int n;
+
+	while (count > 0)
+	{
+		if ((n = read(fd, p, count)) <= 0)
+			return -1;
+		p += n;
+		count -= n;
+	}
+	return 0;
+}
+
+// 回显服务：从 in 读取 size 字节的请求，原样写到 out，直到对方关闭
+static void echo(int in, int out, int size)
+{
+	while (!read_full(in, buf, size))
+		if (write(out, buf, size) != size)
+			break;
+	_exit(0);
+}
+
+// 客户端：通过 out 发送 rounds 个 size 字节的请求，从 in 读回应答
+// 返回：所用的滴答数，出错返回 -1
+static long client(int in, int out, int size, int rounds)
+{
+	struct tms tms;
+	long start;
+	int i;
+
+	start = times(&tms);
+	for (i = 0; i < rounds; i++)
+		if (write(out, buf, size) != size || read_full(in, buf, size))
+			return -1;
+	return times(&tms) - start;
+}
+
+// 经 UNIX 域套接字的往返
+static long run_socket(int size, int rounds)
+{
+	struct sockaddr_un addr;
+	int lfd, fd, status;
+	long ticks;
+
+	addr.sun_family = AF_UNIX;
+	ucat(addr.sun_path, SOCK_NAME);
+	unlink(SOCK_NAME);
+	if ((lfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+		bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(lfd, 1) < 0)
+		return -1;
+
+	switch (fork())
+	{
+	case -1:
+		return -1;
+	case 0:
+		if ((fd = accept(lfd, 0, 0)) < 0)
+			_exit(1);
+		close(lfd);
+		echo(fd, fd, size);
+	}
+
+	close(lfd);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+		connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		return -1;
+	ticks = client(fd, fd, size, rounds);
+	close(fd);
+	wait(&status);
+	unlink(SOCK_NAME);
+	return ticks;
+}
+
+// 经一对管道的往返，作为比较
+static long run_pipe(int size, int rounds)
+{
+	int req[2], resp[2], status;
+	long ticks;
+
+	if (pipe(req) < 0 || pipe(resp) < 0)
+		return -1;
+	switch (fork())
+	{
+	case -1:
+		return -1;
+	case 0:
+		close(req[1]);
+		close(resp[0]);
+		echo(req[0], resp[1], size);
+	}
+	close(req[0]);
+	close(resp[1]);
+	ticks = client(resp[0], req[1], size, rounds);
+	close(req[1]);
+	close(resp[0]);
+	wait(&status);
+	return ticks;
+}
+
+// 输出 name 加上消息长度作为测试名的一行结果，每次往返请求和应答各 size 字节
+// 返回：出错返回 -1
+static int report(const char *name, int size, int rounds, long ticks)
+{
+	char full[32], num[12];
+
+	ucat(ucat(full, name), uitoa(size, num));
+	if (ticks < 0)
+	{
+		say("ERROR ");
+		say(full);
+		say(" failed\n");
+		return -1;
+	}
+	say_result(full, rounds, ticks, rounds, 2L * rounds * size / 1024);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static int sizes[] = {1, 64, 512, 4096};
+	int rounds, i, err = 0;
+
+	rounds = argc > 1 ? uatol(argv[1]) : 2000;
+	if (rounds <= 0)
+		rounds = 2000;
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = 'x';
+	say_open();
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		if (report("unix_rtt_", sizes[i], rounds, run_socket(sizes[i], rounds)))
+			err = 1;
+		if (report("pipe_rtt_", sizes[i], rounds, run_pipe(sizes[i], rounds)))
+			err = 1;
+	}
+	return err;
+}
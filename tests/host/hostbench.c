@@ -0,0 +1,273 @@
+/*
+ * fs/ 和 mm/ 算法的宿主机测试：在模拟磁盘上运行固定的操作序列，输出操作次数和 CPU 周期数
+ *
+ *     hostbench [测试名[=次数]] ...
+ *
+ * 不带参数时按下表顺序运行全部测试。每项测试开始前都把伪随机数种子重置为同一个值，
+ * 所以同一项测试每次访问的块、文件和页面都一样，改动数据结构前后的结果可以直接比较。
+ * 每项测试输出一行：
+ *
+ *     RESULT name= ops= cycles= cycles_per_op= hits= misses= disk_reads= disk_writes=
+ *
+ * hits/misses 是 getblk() 在高速缓冲中找到和没找到块的次数，disk_* 是模拟磁盘的读写块数
+ */
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <fcntl.h>
+
+#include "sim.h"
+
+extern int sys_mkdir(const char *pathname, int mode);
+
+// 各测试的默认次数
+#define NR_FILES 1000	// create 建立的文件数，也是 lookup 查找的范围
+#define NR_BIG 3000		// create_block 为大文件分配的块数，超过直接块和一次间接块
+#define NR_ALLOC 4000	// new_block 每轮分配的块数
+#define NR_PAGES 512	// get_free_page 每轮分配的页面数
+
+static unsigned long seed;
+static int nr_files = 0;
+static struct m_inode *big = NULL;
+static int nr_big = 0;
+static int tmp[NR_ALLOC > NR_PAGES ? NR_ALLOC : NR_PAGES];
+
+static int rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+// 打乱 a[0..n-1] 的顺序
+static void shuffle(int *a, int n)
+{
+	int i, j, t;
+
+	for (i = n - 1; i > 0; i--)
+	{
+		j = ((rnd() << 15) | rnd()) % (i + 1);
+		t = a[i], a[i] = a[j], a[j] = t;
+	}
+}
+
+static char *file_name(int i)
+{
+	static char name[] = "/d/f00000";
+	int k;
+
+	for (k = 8; k > 3; k--, i /= 10)
+		name[k] = '0' + i % 10;
+	return name;
+}
+
+// getblk：读并释放 n 个块，80% 落在 256 块的热区内，其余分布在整个磁盘上，远多于缓冲区数
+static int t_getblk(int n)
+{
+	struct buffer_head *bh;
+	int i, block;
+
+	for (i = 0; i < n; i++)
+	{
+		if (rnd() % 5)
+			block = 1024 + rnd() % 256;
+		else
+			block = 100 + ((rnd() << 15) | rnd()) % (SIM_BLOCKS - 100);
+		if (!(bh = bread(SIM_DEV, block)))
+			panic("bread failed");
+		brelse(bh);
+	}
+	return n;
+}
+
+// create：在 /d 中再建立 n 个文件（open_namei() 中 find_entry() 和 add_entry() 都要扫描整个目录）
+static int t_create(int n)
+{
+	struct m_inode *inode;
+	int i;
+
+	sys_mkdir("/d", 0755);
+	for (i = 0; i < n; i++, nr_files++)
+	{
+		if (open_namei(file_name(nr_files), O_CREAT | O_WRONLY, 0644, &inode))
+			panic("cannot create file");
+		iput(inode);
+	}
+	return n;
+}
+
+// lookup：在 /d 中随机查找 n 次，八分之一查找不存在的文件
+static int t_lookup(int n)
+{
+	struct m_inode *inode;
+	int i, k;
+
+	for (i = 0; i < n; i++)
+	{
+		k = rnd() % nr_files;
+		if (!(rnd() & 7))
+			k += nr_files;
+		inode = namei(file_name(k));
+		if (!inode != (k >= nr_files))
+			panic("lookup gives wrong result");
+		iput(inode);
+	}
+	return n;
+}
+
+// create_block：为 /big 再分配 n 个块
+static int t_create_block(int n)
+{
+	int i;
+
+	if (!big && open_namei("/big", O_CREAT | O_WRONLY, 0644, &big))
+		panic("cannot create /big");
+	for (i = 0; i < n; i++, nr_big++)
+		if (!create_block(big, nr_big))
+			panic("create_block failed");
+	return n;
+}
+
+// bmap：在 /big 中随机取 n 个块号映射到逻辑块号
+static int t_bmap(int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (!bmap(big, ((rnd() << 15) | rnd()) % nr_big))
+			panic("bmap gives hole");
+	return n;
+}
+
+// new_block：分配 NR_ALLOC 块，再以随机顺序释放，共 n 轮
+static int t_new_block(int n)
+{
+	int i, j;
+
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < NR_ALLOC; j++)
+			if (!(tmp[j] = new_block(SIM_DEV)))
+				panic("new_block failed");
+		shuffle(tmp, NR_ALLOC);
+		for (j = 0; j < NR_ALLOC; j++)
+			free_block(SIM_DEV, tmp[j]);
+	}
+	return n * NR_ALLOC * 2;
+}
+
+// get_free_page：分配 NR_PAGES 页，再以随机顺序释放，共 n 轮
+static int t_get_free_page(int n)
+{
+	int i, j;
+
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < NR_PAGES; j++)
+			if (!(tmp[j] = get_free_page()))
+				panic("out of memory");
+		shuffle(tmp, NR_PAGES);
+		for (j = 0; j < NR_PAGES; j++)
+			free_page(tmp[j]);
+	}
+	return n * NR_PAGES * 2;
+}
+
+// lookup 和 bmap 需要的文件在计时之前建立
+static void need_files(void)
+{
+	if (!nr_files)
+		t_create(NR_FILES);
+}
+
+static void need_big(void)
+{
+	if (!big)
+		t_create_block(NR_BIG);
+}
+
+static struct test
+{
+	const char *name;
+	int (*fn)(int n);	 // 返回完成的操作数
+	int n;				 // 默认次数（或轮数）
+	void (*setup)(void); // 计时前的准备，可以为空
+} tests[] = {
+	{"getblk", t_getblk, 200000, NULL},
+	{"create", t_create, NR_FILES, NULL},
+	{"lookup", t_lookup, 20000, need_files},
+	{"create_block", t_create_block, NR_BIG, NULL},
+	{"bmap", t_bmap, 200000, need_big},
+	{"new_block", t_new_block, 10, NULL},
+	{"get_free_page", t_get_free_page, 100, NULL},
+};
+
+#define NR_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+static void run(struct test *t, int n)
+{
+	struct blk_stat b0, b1;
+	struct sim_disk_stat d0;
+	unsigned long long c;
+	int ops;
+
+	if (t->setup)
+		t->setup();
+	seed = 1;
+	d0 = sim_disk_stat;
+	get_blk_stat(&b0);
+	c = rdtsc();
+	ops = t->fn(n);
+	c = rdtsc() - c;
+	get_blk_stat(&b1);
+	hprintf("RESULT name=%s ops=%d cycles=", t->name, ops);
+	hput64(c);
+	hprintf(" cycles_per_op=");
+	hput64(udiv64(c, ops ? ops : 1));
+	hprintf(" hits=%u misses=%u disk_reads=%u disk_writes=%u\n",
+			b1.getblk_hit - b0.getblk_hit, b1.getblk_miss - b0.getblk_miss,
+			sim_disk_stat.reads - d0.reads, sim_disk_stat.writes - d0.writes);
+}
+
+// 参数形如 "name" 或 "name=n"
+static int run_arg(const char *arg)
+{
+	struct test *t;
+	const char *a, *b;
+	int n;
+
+	for (t = tests; t < tests + NR_TESTS; t++)
+	{
+		for (a = arg, b = t->name; *b && *a == *b; a++, b++)
+			;
+		if (*b || (*a && *a != '='))
+			continue;
+		n = t->n;
+		if (*a == '=')
+			for (n = 0; *++a >= '0' && *a <= '9';)
+				n = n * 10 + *a - '0';
+		if (n <= 0)
+			break;
+		run(t, n);
+		return 0;
+	}
+	hprintf("hostbench: bad test '%s'\n", arg);
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	sim_init();
+	if (argc < 2)
+		for (i = 0; i < NR_TESTS; i++)
+			run(tests + i, tests[i].n);
+	for (i = 1; i < argc; i++)
+		if (run_arg(argv[i]))
+			return 1;
+	if (big)
+		iput(big);
+	sync_dev(SIM_DEV);
+	return 0;
+}
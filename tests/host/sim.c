@@ -0,0 +1,302 @@
+/*
+ * 在宿主机上运行 fs/ 和 mm/ 代码的模拟环境
+ *
+ * 程序是不带 C 库的 32 位静态程序，直接用 Linux i386 的系统调用（int 0x80）输出和映射内存。
+ * 这里提供内核代码需要的其余符号：只有一个进程，从不需要睡眠，块设备是内存中的一块磁盘，
+ * ll_rw_block() 同步完成读写
+ */
+
+#include <stdarg.h>
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/trace.h>
+#include <sys/stat.h>
+#include <asm/memory.h>
+
+#include "sim.h"
+
+extern int vsprintf(char *buf, const char *fmt, va_list args);
+extern void mem_init(long start, long end);
+extern void mount_root(void);
+
+// 高速缓冲从 end 开始，内核中 end 是连接程序给出的内核末端
+char end[SIM_BUFFER_MEM] __attribute__((aligned(4096)));
+
+static unsigned char disk[SIM_BLOCKS][BLOCK_SIZE];
+struct sim_disk_stat sim_disk_stat;
+
+static struct task_struct sim_task;
+struct task_struct *current = &sim_task;
+struct task_struct *task[NR_TASKS] = {&sim_task};
+long volatile jiffies = 0;
+long startup_time = 0;
+unsigned long pg_dir[1024];
+int trace_on = 0;
+
+// 宿主机系统调用
+
+void host_write(int fd, const char *buf, int count)
+{
+	long res;
+
+	__asm__ __volatile__("int $0x80"
+						 : "=a"(res)
+						 : "0"(4), "b"(fd), "c"(buf), "d"(count));
+}
+
+void host_exit(int code)
+{
+	__asm__ __volatile__("int $0x80" ::"a"(1), "b"(code));
+	for (;;)
+		;
+}
+
+// 旧的 mmap 调用（90 号），参数放在一个结构中。固定地址、私有匿名、可读写
+static long host_mmap(unsigned long addr, unsigned long len)
+{
+	unsigned long args[6] = {addr, len, 3, 0x32, -1, 0};
+	long res;
+
+	__asm__ __volatile__("int $0x80"
+						 : "=a"(res)
+						 : "0"(90), "b"(args)
+						 : "memory");
+	return res;
+}
+
+int hprintf(const char *fmt, ...)
+{
+	static char buf[1024];
+	va_list args;
+	int i;
+
+	va_start(args, fmt);
+	i = vsprintf(buf, fmt, args);
+	va_end(args);
+	host_write(1, buf, i);
+	return i;
+}
+
+// 64 位数除以 32 位数。没有连接 libgcc，不能直接用 64 位除法
+unsigned long long udiv64(unsigned long long n, unsigned long d)
+{
+	unsigned long long q = 0, r = 0;
+	int i;
+
+	for (i = 63; i >= 0; i--)
+	{
+		r = (r << 1) | ((n >> i) & 1);
+		if (r >= d)
+		{
+			r -= d;
+			q |= 1ULL << i;
+		}
+	}
+	return q;
+}
+
+// 以十进制输出 64 位数（vsprintf() 不支持 %llu）
+void hput64(unsigned long long n)
+{
+	char buf[24];
+	int i = sizeof(buf);
+
+	do
+	{
+		unsigned long long q = udiv64(n, 10);
+		buf[--i] = '0' + (n - q * 10);
+		n = q;
+	} while (n);
+	host_write(1, buf + i, sizeof(buf) - i);
+}
+
+// 内核函数
+
+int printk(const char *fmt, ...)
+{
+	static char buf[1024];
+	va_list args;
+	int i;
+
+	va_start(args, fmt);
+	i = vsprintf(buf, fmt, args);
+	va_end(args);
+	host_write(2, buf, i);
+	return i;
+}
+
+volatile void panic(const char *s)
+{
+	printk("Kernel panic: %s\n", s);
+	host_exit(2);
+}
+
+void do_exit(long code)
+{
+	panic("do_exit");
+}
+
+// 只有一个进程，等待的条件不会由别人改变，需要睡眠就说明出错了
+void sleep_on(struct task_struct **p)
+{
+	panic("sleep_on");
+}
+
+void interruptible_sleep_on(struct task_struct **p)
+{
+	panic("interruptible_sleep_on");
+}
+
+void wake_up(struct task_struct **p)
+{
+	if (p && *p)
+		*p = NULL;
+}
+
+void schedule(void)
+{
+}
+
+// IRQ_LATENCY 下 cli()/sti()/restore_flags() 调用这几个函数。用户态不能执行 cli/sti，这里什么也不做
+void irqlat_cli(void)
+{
+}
+
+void irqlat_sti(void)
+{
+}
+
+void irqlat_restore(unsigned long flags)
+{
+}
+
+void trace_event(int event, unsigned long a, unsigned long b)
+{
+}
+
+// 模拟块设备，与 make_request() 一样跳过不需要的读写
+void ll_rw_block(int rw, struct buffer_head *bh)
+{
+	if (bh->b_dev != SIM_DEV || bh->b_blocknr >= SIM_BLOCKS)
+	{
+		printk("Trying to read nonexistent block-device\n\r");
+		return;
+	}
+	if (rw == READA)
+		rw = READ;
+	else if (rw == WRITEA)
+		rw = WRITE;
+	if ((rw == WRITE && !bh->b_dirt) || (rw == READ && bh->b_uptodate))
+		return;
+	blk_stat.requests[MAJOR(bh->b_dev)]++;
+	if (rw == READ)
+	{
+		memcpy(bh->b_data, disk[bh->b_blocknr], BLOCK_SIZE);
+		sim_disk_stat.reads++;
+	}
+	else
+	{
+		memcpy(disk[bh->b_blocknr], bh->b_data, BLOCK_SIZE);
+		sim_disk_stat.writes++;
+	}
+	bh->b_dirt = 0;
+	bh->b_uptodate = 1;
+}
+
+int blk_queue_depth(int major)
+{
+	return 0;
+}
+
+int floppy_change(unsigned int nr)
+{
+	return 0;
+}
+
+void wait_for_keypress(void)
+{
+}
+
+// 没有编译进来的子系统
+
+struct mmap_struct *find_mmap(unsigned long addr)
+{
+	return NULL;
+}
+
+int find_shm(unsigned long addr)
+{
+	return 0;
+}
+
+void free_pipe(struct m_inode *inode)
+{
+}
+
+void sock_release(struct m_inode *inode)
+{
+}
+
+void proc_read_super(struct super_block *s)
+{
+}
+
+void proc_read_inode(struct m_inode *inode)
+{
+}
+
+int proc_lookup(struct m_inode *dir, const char *name, int namelen)
+{
+	return 0;
+}
+
+// 在模拟磁盘上建立一个空的 MINIX 文件系统，只有根目录，格式同 tests/bench/mkhd.py
+void sim_mkfs(int ninodes)
+{
+	struct d_super_block *sb = (struct d_super_block *)disk[1];
+	struct d_inode *root;
+	struct dir_entry *de;
+	int i, j;
+
+	for (i = 0; i < SIM_BLOCKS; i++)
+		for (j = 0; j < BLOCK_SIZE; j++)
+			disk[i][j] = 0;
+	sb->s_ninodes = ninodes;
+	sb->s_nzones = SIM_BLOCKS;
+	sb->s_imap_blocks = (ninodes + 1 + 8191) / 8192;
+	sb->s_zmap_blocks = (SIM_BLOCKS + 8191) / 8192;
+	sb->s_firstdatazone = 2 + sb->s_imap_blocks + sb->s_zmap_blocks +
+						  (ninodes + INODES_PER_BLOCK - 1) / INODES_PER_BLOCK;
+	sb->s_log_zone_size = 0;
+	sb->s_max_size = (7 + 512 + 512 * 512) * BLOCK_SIZE;
+	sb->s_magic = SUPER_MAGIC;
+
+	// 位图的第 0 位不用；1 号 i 节点和第一个数据块分给根目录
+	disk[2][0] = 3;
+	disk[2 + sb->s_imap_blocks][0] = 3;
+
+	root = (struct d_inode *)disk[2 + sb->s_imap_blocks + sb->s_zmap_blocks];
+	root->i_mode = S_IFDIR | 0755;
+	root->i_nlinks = 2;
+	root->i_size = 2 * sizeof(struct dir_entry);
+	root->i_zone[0] = sb->s_firstdatazone;
+	de = (struct dir_entry *)disk[sb->s_firstdatazone];
+	de[0].inode = de[1].inode = ROOT_INO;
+	de[0].name[0] = de[1].name[0] = de[1].name[1] = '.';
+}
+
+// 准备主内存区和高速缓冲，在模拟磁盘上建立文件系统并作为根文件系统安装
+void sim_init(void)
+{
+	if (host_mmap(SIM_MEM_START, SIM_MEM_END - SIM_MEM_START) != SIM_MEM_START)
+	{
+		printk("cannot map main memory at %x\n", SIM_MEM_START);
+		host_exit(1);
+	}
+	mem_init(SIM_MEM_START, SIM_MEM_END);
+	buffer_init((long)end + SIM_BUFFER_MEM);
+	current->umask = 0022;
+	sim_mkfs(4096);
+	ROOT_DEV = SIM_DEV;
+	mount_root();
+}
@@ -0,0 +1,46 @@
+/*
+ * 宿主机上的模拟环境，见 sim.c
+ */
+
+#ifndef _SIM_H
+#define _SIM_H
+
+// 模拟磁盘的设备号（/dev/hd1）和大小（块数），磁盘放在内存中
+#define SIM_DEV 0x301
+#define SIM_BLOCKS 16384
+
+// 高速缓冲占用的内存（buffer_init() 的参数减去 end）
+#define SIM_BUFFER_MEM (2 * 1024 * 1024)
+
+// 主内存区：get_free_page() 返回的是物理地址，这里把宿主机上同样的地址映射成可读写的匿名内存
+#define SIM_MEM_START 0x100000
+#define SIM_MEM_END 0x500000
+
+// 模拟磁盘的读写次数
+struct sim_disk_stat
+{
+	unsigned long reads;
+	unsigned long writes;
+};
+
+extern struct sim_disk_stat sim_disk_stat;
+
+extern void sim_init(void);
+extern void sim_mkfs(int ninodes);
+
+extern void host_write(int fd, const char *buf, int count);
+extern void host_exit(int code) __attribute__((noreturn));
+extern int hprintf(const char *fmt, ...);
+extern void hput64(unsigned long long n);
+extern unsigned long long udiv64(unsigned long long n, unsigned long d);
+
+static inline unsigned long long rdtsc(void)
+{
+	unsigned long long t;
+
+	__asm__ __volatile__("rdtsc"
+						 : "=A"(t));
+	return t;
+}
+
+#endif
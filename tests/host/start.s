@@ -0,0 +1,17 @@
+# hostbench 的启动代码（宿主机 Linux i386 程序，不用 C 库）
+# 进入时栈顶是 argc，其后紧接着 argv 数组本身。内核代码用 get_fs_byte() 取用户空间的文件名，
+# 这里让 fs 与 ds 相同，文件名就可以直接放在程序的数据中
+
+.text
+.globl _start
+_start:
+	movw %ds,%ax
+	movw %ax,%fs
+	leal 4(%esp),%eax
+	pushl %eax
+	pushl 4(%esp)
+	call main
+	movl %eax,%ebx
+	movl $1,%eax
+	int $0x80
+1:	jmp 1b